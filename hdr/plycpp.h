@@ -25,9 +25,18 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <unordered_map>
 #include <cassert>
 #include <algorithm>
 #include <typeindex>
+#include <iterator>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <cstring>
 
 
 namespace plycpp
@@ -44,7 +53,42 @@ namespace plycpp
 	enum FileFormat
 	{
 		ASCII,
-		BINARY
+		/// Binary, with the endianness of the current architecture
+		BINARY,
+		BINARY_LITTLE_ENDIAN,
+		BINARY_BIG_ENDIAN
+	};
+
+	/// Compression of a PLY file
+	enum Compression
+	{
+		UNCOMPRESSED,
+		/// gzip or zlib stream (".gz" extension)
+		GZIP,
+		/// Zstandard stream (".zst" extension)
+		ZSTD
+	};
+
+	/// Whether plycpp was built with support for a compression (see PLYCPP_WITH_ZLIB and PLYCPP_WITH_ZSTD in CMakeLists.txt)
+	bool isCompressionSupported(const Compression compression);
+
+	/// Compression matching the extension of a file name: ".gz" for GZIP, ".zst" for ZSTD, none otherwise
+	Compression compressionFromExtension(const std::string& filename);
+
+	/// Options of the compression of saved data
+	struct CompressionOptions
+	{
+		CompressionOptions(const Compression compression = UNCOMPRESSED)
+			: compression(compression)
+		{}
+
+		Compression compression;
+
+		/// Compression level, 0 for the default level of the codec
+		int level = 0;
+
+		/// Number of threads compressing ZSTD data (0 to use all the hardware threads)
+		unsigned int threadsCount = 0;
 	};
 
 	class Exception : public std::exception
@@ -69,7 +113,8 @@ namespace plycpp
 	};
 
 	/// A list of elements that can be accessed through a given key for convenience.
-	/// Access by key is not meant to be fast, but practical.
+	/// Elements keep their insertion order, and are found by key through a hash index.
+	/// Keys must not be modified through iterators.
 	template<typename Key, typename Data>
 	class IndexedList
 	{
@@ -80,41 +125,44 @@ namespace plycpp
 		typedef typename Container::iterator iterator;
 		typedef typename Container::const_iterator const_iterator;
 
-		std::shared_ptr<Data> operator[] (const Key& key)
+		const std::shared_ptr<Data>& operator[] (const Key& key)
 		{
-			auto it = std::find_if(begin(), end(), [&key](const MyKeyData& a){ return a.key == key; });
-			if (it != end())
-				return it->data;
-			else
-				throw Exception("Invalid key.");
+			return container[indexOf(key)].data;
 		}
 
 		const std::shared_ptr<const Data> operator[] (const Key& key) const
 		{
-			auto it = std::find_if(begin(), end(), [&key](const MyKeyData& a){ return a.key == key; });
-			if (it != end())
-				return it->data;
-			else
-				throw Exception("Invalid key.");
+			return container[indexOf(key)].data;
 		}
 
-		bool has_key(const Key &key)
+		/// Access an element without sharing its ownership
+		Data& get(const Key& key)
 		{
-			auto it = std::find_if(begin(), end(), [&key](const MyKeyData &a) { return a.key == key; });
-			if (it != end())
-				return true;
-			else
-				return false;
+			return *container[indexOf(key)].data;
+		}
+
+		/// Access an element without sharing its ownership
+		const Data& get(const Key& key) const
+		{
+			return *container[indexOf(key)].data;
+		}
+
+		bool has_key(const Key &key) const
+		{
+			return index.find(key) != index.end();
 		}
 
 		void push_back(const Key& key, const std::shared_ptr<Data>& data)
 		{
+			// The first element of a given key is the one accessed by key
+			index.insert(std::make_pair(key, container.size()));
 			container.push_back(MyKeyData(key, data));
 		}
 
 		void clear()
 		{
 			container.clear();
+			index.clear();
 		}
 
 		iterator begin() { return container.begin(); };
@@ -123,7 +171,143 @@ namespace plycpp
 		const_iterator end() const { return container.end(); };
 
 	private:
+		size_t indexOf(const Key& key) const
+		{
+			auto it = index.find(key);
+			if (it != index.end())
+				return it->second;
+			else
+				throw Exception("Invalid key.");
+		}
+
 		Container container;
+		std::unordered_map<Key, size_t> index;
+	};
+
+	/// Random access iterator over the items of a read-only view, returned by value
+	template<typename View>
+	class ViewIterator
+	{
+	public:
+		typedef std::random_access_iterator_tag iterator_category;
+		typedef typename View::value_type value_type;
+		typedef std::ptrdiff_t difference_type;
+		typedef const value_type* pointer;
+		typedef value_type reference;
+
+		ViewIterator(const View* view = nullptr, const size_t i = 0)
+			: view(view), i(i)
+		{}
+
+		value_type operator*() const { return (*view)[i]; }
+		value_type operator[](const difference_type n) const { return (*view)[i + n]; }
+
+		ViewIterator& operator++() { ++i; return *this; }
+		ViewIterator& operator--() { --i; return *this; }
+		ViewIterator operator++(int) { ViewIterator it(*this); ++i; return it; }
+		ViewIterator operator--(int) { ViewIterator it(*this); --i; return it; }
+		ViewIterator& operator+=(const difference_type n) { i += n; return *this; }
+		ViewIterator& operator-=(const difference_type n) { i -= n; return *this; }
+		ViewIterator operator+(const difference_type n) const { return ViewIterator(view, i + n); }
+		ViewIterator operator-(const difference_type n) const { return ViewIterator(view, i - n); }
+		difference_type operator-(const ViewIterator& other) const { return difference_type(i) - difference_type(other.i); }
+
+		bool operator==(const ViewIterator& other) const { return i == other.i; }
+		bool operator!=(const ViewIterator& other) const { return i != other.i; }
+		bool operator<(const ViewIterator& other) const { return i < other.i; }
+		bool operator>(const ViewIterator& other) const { return i > other.i; }
+		bool operator<=(const ViewIterator& other) const { return i <= other.i; }
+		bool operator>=(const ViewIterator& other) const { return i >= other.i; }
+
+	private:
+		const View* view;
+		size_t i;
+	};
+
+	/// Read-only view over values of type T separated by a fixed number of bytes,
+	/// e.g. a property stored in its own array or interleaved with the other properties of its element.
+	/// Values are returned by copy, so that they may be unaligned. The viewed memory must outlive the view.
+	template<typename T>
+	class StridedSpan
+	{
+	public:
+		typedef T value_type;
+		typedef ViewIterator<StridedSpan<T> > const_iterator;
+
+		StridedSpan(const unsigned char* data = nullptr, const size_t stride = sizeof(T), const size_t size = 0)
+			: data_(data), stride_(stride), size_(size)
+		{}
+
+		T operator[](const size_t i) const
+		{
+			assert(i < size_);
+			T value;
+			std::memcpy(&value, data_ + i * stride_, sizeof(T));
+			return value;
+		}
+
+		size_t size() const { return size_; }
+		bool empty() const { return size_ == 0; }
+		size_t stride() const { return stride_; }
+
+		/// True if values are contiguous and aligned, in which case 'data()' can be used as an array of T
+		bool isContiguous() const
+		{
+			return stride_ == sizeof(T) && reinterpret_cast<uintptr_t>(data_) % alignof(T) == 0;
+		}
+
+		const T* data() const
+		{
+			assert(isContiguous());
+			return reinterpret_cast<const T*>(data_);
+		}
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, size_); }
+
+	private:
+		const unsigned char* data_;
+		size_t stride_;
+		size_t size_;
+	};
+
+	/// Read-only view over N properties of type T of an element, whose items are std::array<T, N> (e.g. xyz coordinates)
+	template<typename T, size_t N>
+	class ElementView
+	{
+	public:
+		typedef std::array<T, N> value_type;
+		typedef ViewIterator<ElementView<T, N> > const_iterator;
+
+		ElementView(const std::array<StridedSpan<T>, N>& channels)
+			: channels(channels)
+		{
+			for (size_t j = 1; j < N; ++j)
+				assert(channels[j].size() == channels[0].size());
+		}
+
+		value_type operator[](const size_t i) const
+		{
+			value_type item;
+			for (size_t j = 0; j < N; ++j)
+				item[j] = channels[j][i];
+			return item;
+		}
+
+		/// View of the j-th property
+		const StridedSpan<T>& channel(const size_t j) const
+		{
+			return channels[j];
+		}
+
+		size_t size() const { return N > 0 ? channels[0].size() : 0; }
+		bool empty() const { return size() == 0; }
+
+		const_iterator begin() const { return const_iterator(this, 0); }
+		const_iterator end() const { return const_iterator(this, size()); }
+
+	private:
+		std::array<StridedSpan<T>, N> channels;
 	};
 
 	class PropertyArray;
@@ -143,10 +327,18 @@ namespace plycpp
 			return type == std::type_index(typeid(T));
 		}
 
+		/// Contiguous read-only access.
+		/// Throws for a view whose values are not contiguous: use a non-const access to copy it first.
 		template<typename T>
 		const T* ptr() const
 		{
 			assert(isOfType<T>());
+			if (viewData)
+			{
+				if (viewStride != stepSize || reinterpret_cast<uintptr_t>(viewData) % alignof(T) != 0)
+					throw Exception("Non contiguous property view. A mutable access is required to copy it.");
+				return reinterpret_cast<const T*>(viewData);
+			}
 			return reinterpret_cast<const T*>(&data[0]);
 		}
 
@@ -154,11 +346,13 @@ namespace plycpp
 		T* ptr()
 		{
 			assert(isOfType<T>());
-			return reinterpret_cast<T*>(data.data());
+			return reinterpret_cast<T*>(mutableBytes());
 		}
 
 		const size_t size() const
 		{
+			if (viewData)
+				return viewSize;
 			assert(data.size() % stepSize == 0);
 			return data.size() / stepSize;
 		}
@@ -167,22 +361,122 @@ namespace plycpp
 		const T& at(const size_t i) const
 		{
 			assert(isOfType<T>());
-			assert((i+1) * stepSize <= data.size());
-			return  *reinterpret_cast<const T*>(&data[i * stepSize]);
+			assert(i < size());
+			return  *reinterpret_cast<const T*>(bytes() + i * stride());
 		}
 
 		template<typename T>
 		T& at(const size_t i)
 		{
 			assert(isOfType<T>());
-			assert((i + 1) * stepSize <= data.size());
-			return  *reinterpret_cast<T*>(&data[i * stepSize]);
+			assert(i < size());
+			return  *reinterpret_cast<T*>(mutableBytes() + i * stepSize);
+		}
+
+		/// Read-only view over the values, without copying them
+		template<typename T>
+		StridedSpan<T> view() const
+		{
+			assert(isOfType<T>());
+			return StridedSpan<T>(bytes(), stride(), size());
+		}
+
+		/// Address of the first value
+		const unsigned char* bytes() const
+		{
+			return viewData ? viewData : data.data();
+		}
+
+		/// Distance in bytes between two consecutive values
+		size_t stride() const
+		{
+			return viewData ? viewStride : stepSize;
+		}
+
+		/// Address of the first value, for modification. A read-only view is copied first.
+		unsigned char* mutableBytes()
+		{
+			materialize();
+			return storageData ? storageData : data.data();
+		}
+
+		/// Refer to external read-only memory instead of 'data'.
+		/// 'owner' keeps this memory alive, and values are 'stride' bytes apart.
+		void setView(const std::shared_ptr<const void>& owner, const unsigned char* begin, const size_t stride, const size_t size);
+
+		/// Store the values in external writable memory instead of 'data', e.g. a slice of an arena shared by several properties.
+		/// 'owner' keeps this memory alive, and it holds 'size' contiguous values, modified in place.
+		void setStorage(const std::shared_ptr<void>& owner, unsigned char* begin, const size_t size);
+
+		/// True if the property refers to external memory (a read-only view or a writable storage), in which case 'data' is empty
+		bool isView() const
+		{
+			return viewData != nullptr;
+		}
+
+		/// Copy the content of a read-only view into 'data'. Does nothing for a property owning its data or its storage.
+		void materialize()
+		{
+			if (viewData && !storageData)
+				copyView();
+		}
+
+		/// Number of lists of a list property
+		size_t listsCount() const
+		{
+			assert(isList);
+			return offsets.empty() ? size() / 3 : offsets.size() - 1;
+		}
+
+		/// Index in the values of the first item of the i-th list
+		size_t listOffset(const size_t i) const
+		{
+			assert(isList && i < listsCount());
+			return offsets.empty() ? 3 * i : offsets[i];
+		}
+
+		/// Number of items of the i-th list
+		size_t listSize(const size_t i) const
+		{
+			assert(isList && i < listsCount());
+			return offsets.empty() ? 3 : offsets[i + 1] - offsets[i];
+		}
+
+		/// Items of the i-th list
+		template<typename T>
+		const T* list(const size_t i) const
+		{
+			return ptr<T>() + listOffset(i);
+		}
+
+		template<typename T>
+		T* list(const size_t i)
+		{
+			return ptr<T>() + listOffset(i);
 		}
 
 		std::vector<unsigned char> data;
 		const std::type_index type;
 		const unsigned int stepSize;
 		const bool isList = false;
+
+		/// For list properties, index in the values of the first item of each list,
+		/// followed by the total number of items (compressed sparse row layout).
+		/// Lists are considered to be triplets if empty.
+		std::vector<size_t> offsets;
+
+		/// For list properties, integral type used to store the number of items of each list in a file
+		std::type_index listCountType;
+
+	private:
+		void copyView();
+
+		std::shared_ptr<const void> viewOwner;
+		const unsigned char* viewData = nullptr;
+		size_t viewStride = 0;
+		size_t viewSize = 0;
+		/// Same as viewData for a writable storage, null otherwise
+		unsigned char* storageData = nullptr;
 	};
 
 	class ElementArray
@@ -198,16 +492,345 @@ namespace plycpp
 		{
 			return size_;
 		}
+
+		/// Read-only view over N properties of type T, without copying them.
+		/// Throws if a property is missing.
+		template<typename T, size_t N>
+		ElementView<T, N> view(const std::array<std::string, N>& names) const
+		{
+			std::array<StridedSpan<T>, N> channels;
+			for (size_t j = 0; j < N; ++j)
+			{
+				const PropertyArray& prop = properties.get(names[j]);
+				if (!prop.isOfType<T>() || prop.size() != size_)
+					throw Exception("Type or size inconsistency for property " + names[j]);
+				channels[j] = prop.view<T>();
+			}
+			return ElementView<T, N>(channels);
+		}
+
+		/// Let the properties refer to records interleaved in external read-only memory, 'recordSize' bytes apart,
+		/// in which the values of the properties follow each other in their order. 'owner' keeps this memory alive.
+		void setInterleavedRecords(const std::shared_ptr<const void>& owner, const unsigned char* records, const size_t recordSize);
+
+		/// True if the properties refer to interleaved records, and exactly cover them.
+		/// A mutable access to a property copies it, and breaks the interleaving.
+		bool isInterleaved() const;
+
+		/// Whether the properties have the given types, in order
+		bool hasPropertyTypes(const std::vector<std::type_index>& types) const;
+
+		/// Interleaved records, as an array of structures whose fields have the types 'fieldTypes', in the order of the properties,
+		/// e.g. records<Vertex>({ typeid(float), typeid(float), typeid(float), typeid(unsigned char) }).
+		/// Throws if records are not interleaved, or if they do not match the layout of Record: types of the properties,
+		/// size of a record (hence no padding between the fields) and alignment.
+		template<typename Record>
+		const Record* records(const std::vector<std::type_index>& fieldTypes) const
+		{
+			if (!isInterleaved())
+				throw Exception("Records are not interleaved");
+			if (!hasPropertyTypes(fieldTypes))
+				throw Exception(std::string("Types of the properties do not match the fields of ") + typeid(Record).name());
+			if (sizeof(Record) != recordSize_)
+				throw Exception(std::string("Size of the records does not match ") + typeid(Record).name());
+			if (reinterpret_cast<uintptr_t>(recordsData) % alignof(Record) != 0)
+				throw Exception("Records are not aligned for the requested structure");
+			return reinterpret_cast<const Record*>(recordsData);
+		}
+
+		/// Address of the first interleaved record, or null
+		const unsigned char* recordsBytes() const
+		{
+			return isInterleaved() ? recordsData : nullptr;
+		}
+
+		/// Size of an interleaved record
+		size_t recordSize() const
+		{
+			return recordSize_;
+		}
+
 	private:
+		friend class PlyReader;
 		size_t size_;
+		const unsigned char* recordsData = nullptr;
+		size_t recordSize_ = 0;
+	};
+
+	/// Options of the PLY loader
+	struct LoadOptions
+	{
+		/// Map the file in memory instead of reading it through a stream.
+		/// Properties of binary elements without lists then refer directly to the mapped file
+		/// (see PropertyArray::isView), and are only copied on their first mutable access.
+		bool memoryMapped = false;
+
+		/// Number of threads used to parse ASCII bodies, and to dispatch binary records
+		/// into the property arrays (0 to use all the hardware threads).
+		/// With more than one thread, each element of an ASCII body must be written on its own line.
+		unsigned int threadsCount = 1;
+
+		/// Keep the records of binary elements without lists interleaved as in the file (see ElementArray::records):
+		/// each element is read at once, and its properties refer to its records instead of being dispatched.
+		bool interleaved = false;
+
+		/// Names of the elements to load (all of them if empty). Loading throws if one of them is not in the file.
+		/// Other elements are stepped over without being decoded, and are not read at all at the end of the file.
+		std::vector<std::string> elements;
+
+		/// Names of the properties to load in the selected elements (all of them if empty).
+		/// Loading throws if one of them is in none of the selected elements.
+		/// Other properties are stepped over without being decoded.
+		std::vector<std::string> properties;
+
+		/// Store the loaded properties without lists of all the elements in a single allocation, left uninitialized
+		/// instead of being zero-filled (see PropertyArray::setStorage). Properties referring to the file are not concerned.
+		bool arena = false;
+
+		/// Allocator of the arena, returning at least the requested number of bytes, kept alive by the returned pointer.
+		/// Plain uninitialized heap memory is used if empty; a custom allocator may e.g. recycle buffers between loads.
+		std::function<std::shared_ptr<unsigned char>(size_t)> arenaAllocator;
+
+		/// Read the file by large aligned blocks bypassing the page cache (O_DIRECT on Linux), the next block being read
+		/// in the background while the current one is decoded. Falls back to a buffered stream where unavailable.
+		/// Ignored with memoryMapped.
+		bool directIO = false;
 	};
 
-	/// Load PLY data
+	/// Load PLY data.
+	/// Files compressed with gzip or zstd (see isCompressionSupported) are detected from their first byte, and decompressed
+	/// on the fly by all the load overloads. Decompressed data cannot be referred to (LoadOptions::memoryMapped is ignored).
 	void load(const std::string& filename, PLYData& data);
 
-	/// Save PLY data
+	/// Load PLY data with specific options
+	void load(const std::string& filename, PLYData& data, const LoadOptions& options);
+
+	/// Load PLY data from a buffer in memory, e.g. a payload received over the network, without a temporary file.
+	/// With LoadOptions::memoryMapped, properties of binary elements without lists refer to the buffer instead of
+	/// copying it (see PropertyArray::isView), and the buffer must then outlive them.
+	void load(const void* buffer, const size_t size, PLYData& data);
+
+	/// Load PLY data from a buffer in memory with specific options
+	void load(const void* buffer, const size_t size, PLYData& data, const LoadOptions& options);
+
+	/// Load PLY data from a stream, e.g. backed by a custom std::streambuf reading from any source.
+	/// LoadOptions::memoryMapped is ignored. Elements that are not loaded are stepped over by seeking when possible,
+	/// and read through otherwise.
+	void load(std::istream& fin, PLYData& data);
+
+	/// Load PLY data from a stream with specific options
+	void load(std::istream& fin, PLYData& data, const LoadOptions& options);
+
+	/// Description of a PLY file, read from its header only
+	struct PLYHeader
+	{
+		/// Offset of the records of an element that cannot be computed from the header
+		static const size_t unknownOffset = static_cast<size_t>(-1);
+
+		/// ASCII, BINARY_LITTLE_ENDIAN or BINARY_BIG_ENDIAN
+		FileFormat format;
+
+		/// Elements with their number of records, and their properties without any data
+		PLYData elements;
+
+		/// Byte offset of the body in the file
+		size_t bodyOffset;
+
+		/// Byte offset of the records of each element in the file, in the order of 'elements'.
+		/// Offsets are only known in binary bodies, up to the first element with list properties.
+		std::vector<size_t> elementOffsets;
+	};
+
+	/// Read the header of a PLY file, without reading its body.
+	/// Offsets of a compressed file refer to its decompressed content.
+	void readHeader(const std::string& filename, PLYHeader& header);
+
+	/// Load the records [first, first + count) of an element of a binary file, without reading the rest of the body.
+	/// The element and those preceding it must not have list properties, and the file must not be compressed.
+	void loadRange(const std::string& filename, const std::string& elementName, const size_t first, const size_t count, PLYData& data);
+
+	/// Load a range of records of an element with specific options (LoadOptions::elements is ignored)
+	void loadRange(const std::string& filename, const std::string& elementName, const size_t first, const size_t count, PLYData& data, const LoadOptions& options);
+
+	/// Options of the asynchronous loader
+	struct AsyncLoadOptions
+	{
+		/// Options of the load of each file
+		LoadOptions load;
+
+		/// Number of files decoded at the same time (0 to use all the hardware threads)
+		unsigned int threadsCount = 1;
+
+		/// Maximum number of files read in advance, waiting to be decoded
+		size_t prefetchCount = 2;
+
+		/// Maximum total size in bytes of the files read in advance (0 for no limit).
+		/// A larger file is still read once all the files read in advance have been decoded.
+		size_t maxPrefetchedBytes = 0;
+	};
+
+	class AsyncLoaderState;
+
+	/// Loader of a sequence of PLY files, reading the next files while the previous ones are being decoded.
+	/// Files are read whole in memory by a reader thread, then decoded by other threads as with load(buffer, ...).
+	class AsyncLoader
+	{
+	public:
+		AsyncLoader(const AsyncLoadOptions& options = AsyncLoadOptions());
+
+		/// Wait for the end of the loads already requested
+		~AsyncLoader();
+
+		/// Request the load of a file, in the order of the requests.
+		/// The future holds the loaded data, or the Exception raised by the load.
+		std::future<PLYData> load(const std::string& filename);
+
+	private:
+		AsyncLoader(const AsyncLoader&);
+		AsyncLoader& operator=(const AsyncLoader&);
+
+		std::unique_ptr<AsyncLoaderState> state;
+	};
+
+	class BinaryReader;
+	class ASCIITokenizer;
+	class ASCIIWriter;
+	class WorkerPool;
+
+	/// Reader of a PLY file by batches of elements, to process files that do not fit in memory
+	class PlyReader
+	{
+	public:
+		/// Open a PLY file and parse its header.
+		/// Elements and properties are selected by 'options' as for load(), and binary records of each batch
+		/// are dispatched with 'options.threadsCount' threads. Compressed files are not supported.
+		PlyReader(const std::string& filename, const LoadOptions& options = LoadOptions());
+		~PlyReader();
+
+		/// Elements and properties of the file that are selected by the options, without any data
+		const PLYData& header() const
+		{
+			return header_;
+		}
+
+		/// Read the next batch of at most 'maxCount' elements into 'batch', and the name of their element into 'name'.
+		/// Elements and properties that are not selected by the options are stepped over.
+		/// Properties of 'batch' are reused when they match the element, so that their storage is recycled.
+		/// Returns false once the whole body has been read.
+		bool readBatch(const size_t maxCount, std::string& name, ElementArray& batch);
+
+	private:
+		PlyReader(const PlyReader&);
+		PlyReader& operator=(const PlyReader&);
+
+		size_t currentIndex() const;
+		void readRecords(ElementArray& records);
+
+		std::ifstream fin;
+		/// Elements and properties of the body
+		PLYData layout;
+		PLYData header_;
+		/// Properties of each element to read that are not loaded
+		std::vector<std::vector<bool> > skipped;
+		bool ascii;
+		bool swapBytes;
+		std::unique_ptr<WorkerPool> workers;
+		std::unique_ptr<BinaryReader> binaryReader;
+		std::unique_ptr<ASCIITokenizer> asciiTokenizer;
+		PLYData::iterator currentElement;
+		size_t elementsRead;
+		std::vector<unsigned char> buffer;
+	};
+
+	/// Save PLY data, compressed with default options if the extension of the file name is ".gz" or ".zst"
 	void save(const std::string& filename, const PLYData& data, const FileFormat format = FileFormat::BINARY);
 
+	/// Save PLY data, compressed on the fly. Throws if the compression is not supported.
+	void save(const std::string& filename, const PLYData& data, const FileFormat format, const CompressionOptions& compression);
+
+	/// Options of the PLY writer
+	struct SaveOptions
+	{
+		FileFormat format = FileFormat::BINARY;
+
+		/// Compression of the file, regardless of its extension
+		CompressionOptions compression;
+
+		/// Write the file by large aligned blocks bypassing the page cache (O_DIRECT on Linux), each block being written
+		/// in the background while the next one is filled. Falls back to a buffered stream where unavailable.
+		bool directIO = false;
+	};
+
+	/// Save PLY data with specific options
+	void save(const std::string& filename, const PLYData& data, const SaveOptions& options);
+
+	/// Save PLY data into a stream, e.g. backed by a custom std::streambuf writing to any destination
+	void save(std::ostream& fout, const PLYData& data, const FileFormat format = FileFormat::BINARY);
+
+	/// Save PLY data at the end of a buffer in memory, grown as needed
+	void save(std::vector<unsigned char>& buffer, const PLYData& data, const FileFormat format = FileFormat::BINARY);
+
+	/// Save compressed PLY data into a stream
+	void save(std::ostream& fout, const PLYData& data, const FileFormat format, const CompressionOptions& compression);
+
+	/// Save compressed PLY data at the end of a buffer in memory
+	void save(std::vector<unsigned char>& buffer, const PLYData& data, const FileFormat format, const CompressionOptions& compression);
+
+	/// Writer of a PLY file by batches of elements, to produce files without holding all their data in memory
+	class PlyWriter
+	{
+	public:
+		/// Create a PLY file with the elements and properties of 'schema', whose data is ignored.
+		/// If 'deferredSizes' is set, the number of records of each element is the number of records
+		/// actually written, patched in the header when closing. Otherwise it is the size of the element of 'schema'.
+		PlyWriter(const std::string& filename, const PLYData& schema, const FileFormat format = FileFormat::BINARY, const bool deferredSizes = false);
+
+		/// Close the file, ignoring errors
+		~PlyWriter();
+
+		/// Append the records of 'batch' to the element 'name'.
+		/// Elements have to be written in the order of the schema, and properties of 'batch' have to match those of the schema.
+		void writeBatch(const std::string& name, const ElementArray& batch);
+
+		/// Complete the file, and check the number of records written for each element
+		void close();
+
+	private:
+		PlyWriter(const PlyWriter&);
+		PlyWriter& operator=(const PlyWriter&);
+
+		void checkElementWritten();
+
+		std::ofstream fout;
+		PLYData schema_;
+		bool swapBytes;
+		bool deferredSizes;
+		bool closed;
+		std::vector<std::streampos> countPositions;
+		std::vector<size_t> elementsWritten;
+		std::unique_ptr<ASCIIWriter> asciiWriter;
+		PLYData::iterator currentElement;
+	};
+
+	/// Interleave 'channelsCount' arrays of 'count' contiguous values of 'valueSize' bytes into 'output'.
+	/// Common layouts (3 or 4 channels of 1, 4 or 8 bytes values) use specialized kernels, vectorized when available.
+	void packValues(const unsigned char* const* channels, const size_t channelsCount, const size_t valueSize, const size_t count, unsigned char* output);
+
+	/// Dispatch 'count' interleaved items of 'channelsCount' values of 'valueSize' bytes into contiguous arrays
+	void unpackValues(const unsigned char* input, const size_t channelsCount, const size_t valueSize, const size_t count, unsigned char* const* channels);
+
+	/// Whether the items of a multichannel vector are contiguous, each made of 'channelsCount' contiguous values of type T
+	template<typename T, typename MultichannelVector>
+	bool isPackedMultichannelVector(const MultichannelVector& cloud, const size_t channelsCount)
+	{
+		if (cloud.size() == 0 || sizeof(cloud[0]) != channelsCount * sizeof(T))
+			return false;
+		const unsigned char* first = reinterpret_cast<const unsigned char*>(&cloud[0][0]);
+		const unsigned char* last = reinterpret_cast<const unsigned char*>(&cloud[cloud.size() - 1][channelsCount - 1]);
+		return reinterpret_cast<const unsigned char*>(&cloud[0]) == first
+			&& last == first + (cloud.size() * channelsCount - 1) * sizeof(T);
+	}
+
 	/// Pack n properties -- each represented by a vector of type T --
 	/// into a multichannel vector (e.g. of type vector<std::array<T, n> >)
 	template<typename T, typename OutputVector>
@@ -221,8 +844,9 @@ namespace plycpp
 		const size_t size = properties.front()->size();
 		const size_t nbProperties = properties.size();
 
-		// Pointers to actual data
-		std::vector<const T*> ptsData;
+		// Pointers to actual data, and distance between consecutive values
+		std::vector<const unsigned char*> ptsData;
+		std::vector<size_t> strides;
 		for (auto& prop : properties)
 		{
 			// Check type consistency
@@ -230,16 +854,23 @@ namespace plycpp
 			{
 				throw Exception(std::string("Missing properties or type inconsistency. I was expecting data of type ") + typeid(T).name());
 			}
-			ptsData.push_back(prop->ptr<T>());
+			ptsData.push_back(prop->bytes());
+			strides.push_back(prop->stride());
 		}
 
 		// Packing
 		output.resize(size);
+		if (std::all_of(strides.begin(), strides.end(), [](const size_t stride) { return stride == sizeof(T); })
+			&& isPackedMultichannelVector<T>(output, nbProperties))
+		{
+			packValues(ptsData.data(), nbProperties, sizeof(T), size, reinterpret_cast<unsigned char*>(&output[0][0]));
+			return;
+		}
 		for (size_t i = 0; i < size; ++i)
 		{
 			for (size_t j = 0; j < nbProperties; ++j)
 			{
-				output[i][j] = ptsData[j][i];
+				std::memcpy(&output[i][j], ptsData[j] + i * strides[j], sizeof(T));
 			}
 		}
 	}
@@ -261,6 +892,14 @@ namespace plycpp
 		}
 
 		// Copy data
+		if (isPackedMultichannelVector<T>(cloud, nbProperties))
+		{
+			std::vector<unsigned char*> channels;
+			for (T* ptData : ptsData)
+				channels.push_back(reinterpret_cast<unsigned char*>(ptData));
+			unpackValues(reinterpret_cast<const unsigned char*>(&cloud[0][0]), nbProperties, sizeof(T), size, channels.data());
+			return;
+		}
 		for (size_t i = 0; i < size; ++i)
 		{
 			for (size_t j = 0; j < nbProperties; ++j)
@@ -340,4 +979,352 @@ namespace plycpp
 		plyData.push_back("vertex", vertex);
 	}
 
+	/// Value of any PLY type, converted to double (exact for all PLY types but double itself)
+	double valueAsDouble(const std::type_index& type, const unsigned char* value);
+
+	/// Binding of a member of a structure to a property of a PLY element.
+	/// Members of type std::vector<T> are bound to list properties.
+	template<typename Record, typename T, T Record::*Member>
+	struct FieldBinding
+	{
+		typedef T Type;
+
+		static T& get(Record& record)
+		{
+			return record.*Member;
+		}
+
+		static const T& get(const Record& record)
+		{
+			return record.*Member;
+		}
+	};
+
+	/// Binding of the member 'member' of a structure of type 'Record'
+#define PLYCPP_FIELD(Record, member) ::plycpp::FieldBinding<Record, decltype(Record::member), &Record::member>
+
+	/// Ordered list of field bindings
+	template<typename... Fields>
+	struct FieldList
+	{};
+
+	/// Compile-time schema of a structure representing an element, to be specialized for each structure, e.g.:
+	///
+	/// template<> struct RecordSchema<Vertex>
+	/// {
+	///     static const char* elementName() { return "vertex"; }
+	///     static const char* const* propertyNames() { static const char* const names[] = { "x", "y", "z" }; return names; }
+	///     typedef FieldList<PLYCPP_FIELD(Vertex, x), PLYCPP_FIELD(Vertex, y), PLYCPP_FIELD(Vertex, z)> Fields;
+	/// };
+	///
+	/// Property names are given in the order of the fields, which is the order of the properties in saved files.
+	template<typename Record>
+	struct RecordSchema;
+
+	/// Location of the values of a property bound to a field
+	struct FieldSource
+	{
+		const PropertyArray* prop;
+		const unsigned char* bytes;
+		size_t stride;
+	};
+
+	/// Decoding and encoding of a field of type T, bound to a property of the same type or to a list of T
+	template<typename T>
+	struct FieldCodec
+	{
+		static const bool isList = false;
+
+		static std::type_index type()
+		{
+			return std::type_index(typeid(T));
+		}
+
+		static void decode(T& value, const FieldSource& source, const size_t i)
+		{
+			std::memcpy(&value, source.bytes + i * source.stride, sizeof(T));
+		}
+
+		static void decodeConverted(T& value, const FieldSource& source, const size_t i)
+		{
+			value = static_cast<T>(valueAsDouble(source.prop->type, source.bytes + i * source.stride));
+		}
+
+		static unsigned char* encode(const T& value, unsigned char* output)
+		{
+			std::memcpy(output, &value, sizeof(T));
+			return output + sizeof(T);
+		}
+
+		static void append(const T& value, PropertyArray& prop)
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			prop.data.insert(prop.data.end(), bytes, bytes + sizeof(T));
+		}
+	};
+
+	template<typename T>
+	struct FieldCodec<std::vector<T> >
+	{
+		static const bool isList = true;
+
+		static std::type_index type()
+		{
+			return std::type_index(typeid(T));
+		}
+
+		static void decode(std::vector<T>& value, const FieldSource& source, const size_t i)
+		{
+			const size_t count = source.prop->listSize(i);
+			value.resize(count);
+			if (count > 0)
+				std::memcpy(value.data(), source.bytes + source.prop->listOffset(i) * sizeof(T), count * sizeof(T));
+		}
+
+		static void decodeConverted(std::vector<T>& value, const FieldSource& source, const size_t i)
+		{
+			const size_t count = source.prop->listSize(i);
+			const unsigned char* items = source.bytes + source.prop->listOffset(i) * source.prop->stepSize;
+			value.resize(count);
+			for (size_t j = 0; j < count; ++j)
+				value[j] = static_cast<T>(valueAsDouble(source.prop->type, items + j * source.prop->stepSize));
+		}
+
+		static unsigned char* encode(const std::vector<T>&, unsigned char*)
+		{
+			throw Exception("Records with list properties cannot be interleaved");
+		}
+
+		static void append(const std::vector<T>& value, PropertyArray& prop)
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(value.data());
+			prop.data.insert(prop.data.end(), bytes, bytes + value.size() * sizeof(T));
+			prop.offsets.push_back(prop.offsets.back() + value.size());
+		}
+	};
+
+	/// Decoding and encoding of all the fields of a record, unrolled at compile time
+	template<typename Record, typename List>
+	struct RecordCodec;
+
+	template<typename Record>
+	struct RecordCodec<Record, FieldList<> >
+	{
+		static const size_t fieldsCount = 0;
+		static const bool hasLists = false;
+		static const size_t recordSize = 0;
+
+		static void describe(std::vector<std::type_index>&, std::vector<bool>&)
+		{}
+
+		static void decode(Record&, const FieldSource*, const size_t)
+		{}
+
+		static void decodeConverted(Record&, const FieldSource*, const size_t)
+		{}
+
+		static void encode(const Record&, unsigned char*)
+		{}
+
+		static void append(const Record&, PropertyArray* const*)
+		{}
+	};
+
+	template<typename Record, typename Field, typename... Others>
+	struct RecordCodec<Record, FieldList<Field, Others...> >
+	{
+		typedef FieldCodec<typename Field::Type> Codec;
+		typedef RecordCodec<Record, FieldList<Others...> > Next;
+
+		static const size_t fieldsCount = 1 + Next::fieldsCount;
+		static const bool hasLists = Codec::isList || Next::hasLists;
+		/// Size of the encoded record, meaningful without lists only
+		static const size_t recordSize = sizeof(typename Field::Type) + Next::recordSize;
+
+		/// Types of the properties, and whether they are lists
+		static void describe(std::vector<std::type_index>& types, std::vector<bool>& lists)
+		{
+			types.push_back(Codec::type());
+			lists.push_back(Codec::isList);
+			Next::describe(types, lists);
+		}
+
+		/// Read the i-th record from properties of the types of the fields
+		static void decode(Record& record, const FieldSource* sources, const size_t i)
+		{
+			Codec::decode(Field::get(record), *sources, i);
+			Next::decode(record, sources + 1, i);
+		}
+
+		/// Read the i-th record from properties of any types
+		static void decodeConverted(Record& record, const FieldSource* sources, const size_t i)
+		{
+			Codec::decodeConverted(Field::get(record), *sources, i);
+			Next::decodeConverted(record, sources + 1, i);
+		}
+
+		/// Write the fields one after the other, for records without lists
+		static void encode(const Record& record, unsigned char* output)
+		{
+			Next::encode(record, Codec::encode(Field::get(record), output));
+		}
+
+		/// Append the fields to properties of their types
+		static void append(const Record& record, PropertyArray* const* props)
+		{
+			Codec::append(Field::get(record), **props);
+			Next::append(record, props + 1);
+		}
+	};
+
+	/// Decode the records of an element according to the schema of Record.
+	/// Throws if a property of the schema is missing, or is a list while the field is not (or conversely).
+	/// Properties of the types of the fields are copied directly; others are converted value by value.
+	template<typename Record>
+	void fromElement(const ElementArray& element, std::vector<Record>& records)
+	{
+		typedef RecordSchema<Record> Schema;
+		typedef RecordCodec<Record, typename Schema::Fields> Codec;
+
+		std::vector<std::type_index> types;
+		std::vector<bool> lists;
+		Codec::describe(types, lists);
+		const char* const* names = Schema::propertyNames();
+
+		std::vector<FieldSource> sources;
+		bool sameTypes = true;
+		for (size_t k = 0; k < Codec::fieldsCount; ++k)
+		{
+			if (!element.properties.has_key(names[k]))
+				throw Exception(std::string("Schema mismatch: missing property ") + names[k] + " in element " + Schema::elementName());
+			const PropertyArray& prop = element.properties.get(names[k]);
+			if (prop.isList != lists[k])
+				throw Exception(std::string("Schema mismatch: property ") + names[k] + (lists[k] ? " is expected to be a list" : " is not expected to be a list"));
+			if (prop.isList ? prop.listsCount() != element.size() : prop.size() != element.size())
+				throw Exception(std::string("Inconsistent size for property ") + names[k]);
+			sameTypes = sameTypes && prop.type == types[k];
+			FieldSource source = { &prop, prop.bytes(), prop.stride() };
+			sources.push_back(source);
+		}
+
+		const size_t size = element.size();
+		records.resize(size);
+		if (size == 0)
+			return;
+		if (sameTypes)
+		{
+			for (size_t i = 0; i < size; ++i)
+				Codec::decode(records[i], sources.data(), i);
+		}
+		else
+		{
+			for (size_t i = 0; i < size; ++i)
+				Codec::decodeConverted(records[i], sources.data(), i);
+		}
+	}
+
+	/// Encode records into an element following the schema of Record.
+	/// Without lists, the properties refer to interleaved records (see ElementArray::records).
+	template<typename Record>
+	std::shared_ptr<ElementArray> toElement(const std::vector<Record>& records)
+	{
+		typedef RecordSchema<Record> Schema;
+		typedef RecordCodec<Record, typename Schema::Fields> Codec;
+
+		std::vector<std::type_index> types;
+		std::vector<bool> lists;
+		Codec::describe(types, lists);
+		const char* const* names = Schema::propertyNames();
+
+		const size_t size = records.size();
+		std::shared_ptr<ElementArray> element(new ElementArray(size));
+		std::vector<PropertyArray*> props;
+		for (size_t k = 0; k < Codec::fieldsCount; ++k)
+		{
+			PropertyArrayPtr prop(new PropertyArray(types[k], 0, lists[k]));
+			if (prop->isList)
+				prop->offsets.push_back(0);
+			else
+				prop->data.reserve(size * prop->stepSize);
+			element->properties.push_back(names[k], prop);
+			props.push_back(prop.get());
+		}
+
+		if (!Codec::hasLists)
+		{
+			std::shared_ptr<std::vector<unsigned char> > buffer(new std::vector<unsigned char>(size * Codec::recordSize));
+			for (size_t i = 0; i < size; ++i)
+				Codec::encode(records[i], buffer->data() + i * Codec::recordSize);
+			element->setInterleavedRecords(buffer, buffer->data(), Codec::recordSize);
+			return element;
+		}
+
+		for (size_t i = 0; i < size; ++i)
+			Codec::append(records[i], props.data());
+
+		// Smallest type able to count the items of the lists
+		for (PropertyArray* prop : props)
+		{
+			if (!prop->isList)
+				continue;
+			size_t maxCount = 0;
+			for (size_t i = 0; i + 1 < prop->offsets.size(); ++i)
+				maxCount = std::max(maxCount, prop->offsets[i + 1] - prop->offsets[i]);
+			if (maxCount > std::numeric_limits<uint16_t>::max())
+				prop->listCountType = UINT;
+			else if (maxCount > std::numeric_limits<uint8_t>::max())
+				prop->listCountType = USHORT;
+		}
+		return element;
+	}
+
+	/// Load the element described by the schema of Record (see fromElement)
+	template<typename Record>
+	void loadRecords(const std::string& filename, std::vector<Record>& records, const LoadOptions& options = LoadOptions())
+	{
+		typedef RecordSchema<Record> Schema;
+		typedef RecordCodec<Record, typename Schema::Fields> Codec;
+		const std::string elementName = Schema::elementName();
+
+		PLYHeader header;
+		readHeader(filename, header);
+		if (!header.elements.has_key(elementName))
+			throw Exception("Schema mismatch: missing element " + elementName);
+
+		LoadOptions selection = options;
+		selection.elements.assign(1, elementName);
+		selection.properties.clear();
+		bool hasLists = false;
+		for (const auto& prop : header.elements.get(elementName).properties)
+			hasLists = hasLists || prop.data->isList;
+		if (header.format == FileFormat::ASCII || hasLists)
+		{
+			// Only parse the bound properties. Missing ones are reported by fromElement.
+			const char* const* names = Schema::propertyNames();
+			for (size_t k = 0; k < Codec::fieldsCount; ++k)
+			{
+				if (header.elements.get(elementName).properties.has_key(names[k]))
+					selection.properties.push_back(names[k]);
+			}
+		}
+		else
+		{
+			// Whole records are read at once, and decoded straight from their interleaved layout
+			selection.interleaved = true;
+		}
+
+		PLYData data;
+		load(filename, data, selection);
+		fromElement(data.get(elementName), records);
+	}
+
+	/// Save records as the only element of a PLY file, following the schema of Record
+	template<typename Record>
+	void saveRecords(const std::string& filename, const std::vector<Record>& records, const FileFormat format = FileFormat::BINARY)
+	{
+		PLYData data;
+		data.push_back(RecordSchema<Record>::elementName(), toElement(records));
+		save(filename, data, format);
+	}
+
 }
\ No newline at end of file
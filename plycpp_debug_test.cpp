@@ -0,0 +1,254 @@
+// MIT License
+//
+// Copyright(c) 2021 Romain Brégier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <plycpp.h>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <typeindex>
+#include <cstdio>
+
+namespace
+{
+	int failures = 0;
+
+	void check(const bool condition, const std::string& message)
+	{
+		if (!condition)
+		{
+			std::cout << "FAILED: " << message << std::endl;
+			++failures;
+		}
+	}
+
+	/// ASCII PLY data made of a single vertex with a float property 'x' of the given text
+	std::string asciiVertex(const std::string& x)
+	{
+		return "ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\nend_header\n" + x + "\n";
+	}
+
+	/// Whether loading an ASCII value throws a plycpp::Exception
+	bool rejectsValue(const std::string& x)
+	{
+		const std::string content = asciiVertex(x);
+		try
+		{
+			plycpp::PLYData data;
+			plycpp::load(content.data(), content.size(), data);
+		}
+		catch (const plycpp::Exception&)
+		{
+			return true;
+		}
+		return false;
+	}
+
+	/// Floating point values are parsed as std::istream would do
+	void testASCIIFloatingPoint()
+	{
+		const char* const nonFinite[] = { "nan", "NaN", "-nan", "inf", "-inf", "+inf", "infinity", "Infinity" };
+		for (const char* token : nonFinite)
+			check(rejectsValue(token), std::string("non-finite token rejected: ") + token);
+
+		const char* const valid[] = { "1.5", "-2", "+3e2", ".5", "-.25e-1" };
+		const float expected[] = { 1.5f, -2.f, 300.f, 0.5f, -0.025f };
+		for (size_t i = 0; i < sizeof(valid) / sizeof(valid[0]); ++i)
+		{
+			const std::string content = asciiVertex(valid[i]);
+			plycpp::PLYData data;
+			plycpp::load(content.data(), content.size(), data);
+			check(data.get("vertex").properties.get("x").at<float>(0) == expected[i], std::string("valid token parsed: ") + valid[i]);
+		}
+	}
+
+	/// Whether loading some data throws a plycpp::Exception, and not another exception such as std::bad_alloc
+	bool rejectsData(const std::string& content, const unsigned int threadsCount)
+	{
+		try
+		{
+			plycpp::LoadOptions options;
+			options.threadsCount = threadsCount;
+			plycpp::PLYData data;
+			plycpp::load(content.data(), content.size(), data, options);
+		}
+		catch (const plycpp::Exception&)
+		{
+			return true;
+		}
+		catch (...)
+		{
+		}
+		return false;
+	}
+
+	/// A corrupt list count fails cleanly instead of allocating its whole size
+	void testCorruptListCount()
+	{
+		const std::string header = "element face 1\nproperty list uint int vertex_indices\nend_header\n";
+		const std::string binary = "ply\nformat binary_little_endian 1.0\n" + header + std::string(4, '\xff') + std::string(12, '\0');
+		check(rejectsData(binary, 1), "binary list count larger than the file");
+
+		const std::string ascii = "ply\nformat ascii 1.0\n" + header + "18446744073709551615 1 2 3\n";
+		check(rejectsData(ascii, 1), "ASCII list count larger than the file");
+		check(rejectsData(ascii, 2), "ASCII list count larger than the line");
+	}
+
+	/// Whether a function throws a plycpp::Exception whose message contains 'expected'
+	template<typename Function>
+	bool throwsWith(const Function& function, const std::string& expected)
+	{
+		try
+		{
+			function();
+		}
+		catch (const plycpp::Exception& e)
+		{
+			return std::string(e.what()).find(expected) != std::string::npos;
+		}
+		return false;
+	}
+
+	/// Readers relying on file offsets report compressed files explicitly, whether or not plycpp supports their compression
+	void testCompressedRandomAccess()
+	{
+		const std::string filename = "plycpp_debug_test.ply.gz";
+		{
+			std::ofstream fout(filename, std::ios::binary);
+			fout << "\x1f\x8b\x08" << std::string(32, '\0');
+		}
+		for (const bool memoryMapped : { false, true })
+		{
+			plycpp::LoadOptions options;
+			options.memoryMapped = memoryMapped;
+			check(throwsWith([&]() { plycpp::PLYData data; plycpp::loadRange(filename, "vertex", 0, 1, data, options); }, "uncompressed"),
+				std::string("loadRange rejects compressed files") + (memoryMapped ? " (memory mapped)" : ""));
+		}
+		check(throwsWith([&]() { plycpp::PlyReader reader(filename); }, "uncompressed"), "PlyReader rejects compressed files");
+		std::remove(filename.c_str());
+	}
+
+	/// Names of LoadOptions that are not in the file are reported instead of loading nothing
+	void testUnknownSelection()
+	{
+		const std::string content = "ply\nformat ascii 1.0\nelement vertex 1\nproperty float x\nproperty float y\n"
+			"element face 1\nproperty list uchar int vertex_indices\nend_header\n1 2\n3 0 0 0\n";
+		const auto loads = [&](const std::vector<std::string>& elements, const std::vector<std::string>& properties)
+		{
+			plycpp::LoadOptions options;
+			options.elements = elements;
+			options.properties = properties;
+			plycpp::PLYData data;
+			plycpp::load(content.data(), content.size(), data, options);
+		};
+		check(throwsWith([&]() { loads({ "vertx" }, {}); }, "vertx"), "unknown element rejected");
+		check(throwsWith([&]() { loads({}, { "xx" }); }, "xx"), "unknown property rejected");
+		check(throwsWith([&]() { loads({ "face" }, { "x" }); }, "x"), "property of an element that is not selected rejected");
+		check(!throwsWith([&]() { loads({ "vertex" }, { "y" }); }, ""), "existing element and property accepted");
+
+		const std::string filename = "plycpp_debug_test.ply";
+		{
+			plycpp::PLYData data;
+			plycpp::load(content.data(), content.size(), data);
+			plycpp::save(filename, data);
+		}
+		plycpp::LoadOptions options;
+		options.properties.assign(1, "xx");
+		check(throwsWith([&]() { plycpp::PLYData data; plycpp::loadRange(filename, "vertex", 0, 1, data, options); }, "xx"), "unknown property rejected by loadRange");
+		check(throwsWith([&]() { plycpp::PlyReader reader(filename, options); }, "xx"), "unknown property rejected by PlyReader");
+		std::remove(filename.c_str());
+	}
+
+	struct ColouredPoint
+	{
+		float x, y, z;
+		unsigned char red, green, blue, alpha;
+	};
+
+	struct IntegerPoint
+	{
+		int x, y, z;
+		unsigned char red, green, blue, alpha;
+	};
+
+	struct Point
+	{
+		float x, y, z;
+	};
+
+	/// Typed access to interleaved records checks the layout of the structure against the properties
+	void testInterleavedRecords()
+	{
+		plycpp::PLYData data;
+		std::shared_ptr<plycpp::ElementArray> vertices(new plycpp::ElementArray(2));
+		for (const char* name : { "x", "y", "z" })
+		{
+			plycpp::PropertyArrayPtr prop(new plycpp::PropertyArray(typeid(float), 2));
+			prop->at<float>(0) = 1.f;
+			prop->at<float>(1) = static_cast<float>(name[0]);
+			vertices->properties.push_back(name, prop);
+		}
+		for (const char* name : { "red", "green", "blue", "alpha" })
+		{
+			plycpp::PropertyArrayPtr prop(new plycpp::PropertyArray(typeid(unsigned char), 2));
+			prop->at<unsigned char>(0) = 0;
+			prop->at<unsigned char>(1) = static_cast<unsigned char>(name[0]);
+			vertices->properties.push_back(name, prop);
+		}
+		data.push_back("vertex", vertices);
+		std::vector<unsigned char> buffer;
+		plycpp::save(buffer, data);
+
+		plycpp::LoadOptions options;
+		options.interleaved = true;
+		plycpp::PLYData loaded;
+		plycpp::load(buffer.data(), buffer.size(), loaded, options);
+		const plycpp::ElementArray& element = loaded.get("vertex");
+
+		const std::vector<std::type_index> floatTypes = { typeid(float), typeid(float), typeid(float),
+			typeid(unsigned char), typeid(unsigned char), typeid(unsigned char), typeid(unsigned char) };
+		const ColouredPoint* points = element.records<ColouredPoint>(floatTypes);
+		check(points[1].y == 'y' && points[1].alpha == 'a', "interleaved records read through a matching structure");
+
+		const std::vector<std::type_index> intTypes = { typeid(int), typeid(int), typeid(int),
+			typeid(unsigned char), typeid(unsigned char), typeid(unsigned char), typeid(unsigned char) };
+		check(throwsWith([&]() { element.records<IntegerPoint>(intTypes); }, "Types"), "structure of the same size with other types rejected");
+		check(throwsWith([&]() { element.records<Point>(floatTypes); }, "Size"), "structure smaller than the records rejected");
+	}
+}
+
+int main()
+{
+	testASCIIFloatingPoint();
+	testCorruptListCount();
+	testCompressedRandomAccess();
+	testUnknownSelection();
+	testInterleavedRecords();
+
+	if (failures > 0)
+	{
+		std::cout << failures << " check(s) failed" << std::endl;
+		return 1;
+	}
+	std::cout << "All checks passed" << std::endl;
+	return 0;
+}
@@ -0,0 +1,371 @@
+// MIT License
+//
+// Copyright(c) 2021 Romain Brégier
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+// Usage: plycpp_benchmark [vertices count] [directory of the temporary files] [maximum threads count]
+// Defaults to 100M vertices, the current directory and all the hardware threads.
+
+#include <plycpp.h>
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <array>
+#include <future>
+
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	double secondsSince(const Clock::time_point start)
+	{
+		return std::chrono::duration<double>(Clock::now() - start).count();
+	}
+
+	/// Throughput in MB/s
+	double throughput(const size_t bytes, const double seconds)
+	{
+		return bytes / seconds / 1e6;
+	}
+
+	uint64_t fileSize(const std::string& filename)
+	{
+		std::ifstream fin(filename, std::ios::binary | std::ios::ate);
+		return static_cast<uint64_t>(fin.tellg());
+	}
+
+	/// Pseudo random bytes, identical from a run to another
+	void fillBytes(unsigned char* data, const size_t size, uint32_t seed)
+	{
+		for (size_t i = 0; i < size; ++i)
+		{
+			seed = seed * 1664525u + 1013904223u;
+			data[i] = static_cast<unsigned char>(seed >> 24);
+		}
+	}
+
+	/// Vertices with float positions and normals, and uchar colours.
+	/// Values depend on the index of each vertex in the file, starting at 'first'.
+	std::shared_ptr<plycpp::ElementArray> makeVertices(const size_t first, const size_t count)
+	{
+		std::shared_ptr<plycpp::ElementArray> vertices(new plycpp::ElementArray(count));
+		for (const char* name : { "x", "y", "z", "nx", "ny", "nz" })
+		{
+			plycpp::PropertyArrayPtr prop(new plycpp::PropertyArray(typeid(float), count));
+			float* values = prop->ptr<float>();
+			for (size_t i = 0; i < count; ++i)
+				values[i] = static_cast<float>(first + i) * 0.001f + name[0];
+			vertices->properties.push_back(name, prop);
+		}
+		for (const char* name : { "red", "green", "blue" })
+		{
+			plycpp::PropertyArrayPtr prop(new plycpp::PropertyArray(typeid(unsigned char), count));
+			unsigned char* values = prop->ptr<unsigned char>();
+			for (size_t i = 0; i < count; ++i)
+				values[i] = static_cast<unsigned char>(first + i + name[0]);
+			vertices->properties.push_back(name, prop);
+		}
+		return vertices;
+	}
+
+	/// Write a binary file of 'verticesCount' synthetic vertices, by batches
+	void writeSyntheticFile(const std::string& filename, const size_t verticesCount)
+	{
+		plycpp::PLYData schema;
+		schema.push_back("vertex", makeVertices(0, 0));
+
+		plycpp::PlyWriter writer(filename, schema, plycpp::FileFormat::BINARY, true);
+		const size_t batchSize = 1 << 20;
+		for (size_t first = 0; first < verticesCount; first += batchSize)
+			writer.writeBatch("vertex", *makeVertices(first, std::min(batchSize, verticesCount - first)));
+		writer.close();
+	}
+
+	/// Load a binary file with 1 to 'maxThreadsCount' threads de-interleaving its records
+	void benchmarkBinaryLoad(const std::string& filename, const unsigned int maxThreadsCount)
+	{
+		const uint64_t size = fileSize(filename);
+		std::cout << "Binary load of " << size / 1000000 << " MB" << std::endl;
+		for (unsigned int threadsCount = 1; threadsCount <= maxThreadsCount; ++threadsCount)
+		{
+			plycpp::LoadOptions options;
+			options.threadsCount = threadsCount;
+			plycpp::PLYData data;
+			const Clock::time_point start = Clock::now();
+			plycpp::load(filename, data, options);
+			const double seconds = secondsSince(start);
+			std::cout << "* " << threadsCount << " thread(s): " << std::fixed << std::setprecision(3) << seconds << " s, "
+				<< std::setprecision(0) << throughput(size, seconds) << " MB/s" << std::endl;
+		}
+	}
+
+	/// Generic packing, value by value, as done for layouts without a specialized kernel
+	template<typename T, size_t N>
+	void packScalar(const std::vector<plycpp::PropertyArrayConstPtr>& properties, std::vector<std::array<T, N> >& output)
+	{
+		output.resize(properties.front()->size());
+		for (size_t i = 0; i < output.size(); ++i)
+		{
+			for (size_t j = 0; j < N; ++j)
+				std::memcpy(&output[i][j], properties[j]->bytes() + i * sizeof(T), sizeof(T));
+		}
+	}
+
+	template<typename T, size_t N>
+	void unpackScalar(const std::vector<std::array<T, N> >& cloud, std::vector<plycpp::PropertyArrayPtr>& properties)
+	{
+		for (size_t j = 0; j < N; ++j)
+		{
+			properties[j].reset(new plycpp::PropertyArray(typeid(T), cloud.size()));
+			unsigned char* values = reinterpret_cast<unsigned char*>(properties[j]->ptr<T>());
+			for (size_t i = 0; i < cloud.size(); ++i)
+				std::memcpy(values + i * sizeof(T), &cloud[i][j], sizeof(T));
+		}
+	}
+
+	template<typename T>
+	bool sameValues(const std::vector<plycpp::PropertyArrayPtr>& a, const std::vector<plycpp::PropertyArrayPtr>& b)
+	{
+		for (size_t j = 0; j < a.size(); ++j)
+		{
+			if (a[j]->size() != b[j]->size() || std::memcmp(a[j]->ptr<T>(), b[j]->ptr<T>(), a[j]->size() * sizeof(T)) != 0)
+				return false;
+		}
+		return true;
+	}
+
+	/// Compare packProperties and unpackProperties with the generic value by value loops, and check that their outputs match byte for byte.
+	/// Returns false on a mismatch.
+	template<typename T, size_t N>
+	bool benchmarkPacking(const char* name, const size_t count)
+	{
+		typedef std::vector<std::array<T, N> > Cloud;
+
+		std::vector<plycpp::PropertyArrayConstPtr> properties;
+		for (size_t j = 0; j < N; ++j)
+		{
+			plycpp::PropertyArrayPtr prop(new plycpp::PropertyArray(typeid(T), count));
+			fillBytes(reinterpret_cast<unsigned char*>(prop->ptr<T>()), count * sizeof(T), static_cast<uint32_t>(j + 1));
+			properties.push_back(prop);
+		}
+
+		Cloud scalarCloud;
+		Clock::time_point start = Clock::now();
+		packScalar(properties, scalarCloud);
+		const double packScalarSeconds = secondsSince(start);
+
+		Cloud cloud;
+		start = Clock::now();
+		plycpp::packProperties<T, Cloud>(properties, cloud);
+		const double packSeconds = secondsSince(start);
+
+		std::vector<plycpp::PropertyArrayPtr> scalarProperties(N);
+		start = Clock::now();
+		unpackScalar(cloud, scalarProperties);
+		const double unpackScalarSeconds = secondsSince(start);
+
+		std::vector<plycpp::PropertyArrayPtr> unpackedProperties(N);
+		start = Clock::now();
+		plycpp::unpackProperties<T, Cloud>(cloud, unpackedProperties);
+		const double unpackSeconds = secondsSince(start);
+
+		const bool packMatches = (scalarCloud.size() == cloud.size() && std::memcmp(scalarCloud.data(), cloud.data(), cloud.size() * sizeof(cloud[0])) == 0);
+		const bool unpackMatches = sameValues<T>(scalarProperties, unpackedProperties);
+
+		const size_t bytes = count * N * sizeof(T);
+		std::cout << "* " << name << "x" << N << ": pack " << std::setprecision(0)
+			<< throughput(bytes, packScalarSeconds) << " -> " << throughput(bytes, packSeconds) << " MB/s, unpack "
+			<< throughput(bytes, unpackScalarSeconds) << " -> " << throughput(bytes, unpackSeconds) << " MB/s"
+			<< (packMatches && unpackMatches ? "" : "  MISMATCH") << std::endl;
+		return packMatches && unpackMatches;
+	}
+
+	/// Save to a buffer and load back from it
+	void benchmarkMemoryRoundTrip(const size_t verticesCount)
+	{
+		plycpp::PLYData data;
+		data.push_back("vertex", makeVertices(0, verticesCount));
+
+		std::vector<unsigned char> buffer;
+		Clock::time_point start = Clock::now();
+		plycpp::save(buffer, data);
+		const double saveSeconds = secondsSince(start);
+
+		plycpp::PLYData loaded;
+		start = Clock::now();
+		plycpp::load(buffer.data(), buffer.size(), loaded);
+		const double loadSeconds = secondsSince(start);
+
+		plycpp::LoadOptions options;
+		options.memoryMapped = true;
+		plycpp::PLYData viewed;
+		start = Clock::now();
+		plycpp::load(buffer.data(), buffer.size(), viewed, options);
+		const double viewSeconds = secondsSince(start);
+
+		std::cout << "In-memory round trip of " << buffer.size() / 1000000 << " MB: save " << std::setprecision(0)
+			<< throughput(buffer.size(), saveSeconds) << " MB/s, load " << throughput(buffer.size(), loadSeconds)
+			<< " MB/s, zero-copy load " << std::setprecision(3) << viewSeconds * 1e3 << " ms" << std::endl;
+	}
+
+	/// Load many small files in sequence, then with an AsyncLoader overlapping reads and decoding
+	void benchmarkAsyncLoads(const std::string& directory, const size_t filesCount)
+	{
+		plycpp::PLYData bunny;
+		plycpp::load(std::string(MODELS_DIRECTORY) + "/bunny.ply", bunny);
+		std::vector<std::string> filenames;
+		for (size_t i = 0; i < filesCount; ++i)
+		{
+			filenames.push_back(directory + "/plycpp_benchmark_" + std::to_string(i) + ".ply");
+			plycpp::save(filenames.back(), bunny);
+		}
+
+		Clock::time_point start = Clock::now();
+		for (const std::string& filename : filenames)
+		{
+			plycpp::PLYData data;
+			plycpp::load(filename, data);
+		}
+		const double sequentialSeconds = secondsSince(start);
+
+		plycpp::AsyncLoadOptions options;
+		options.threadsCount = 0;
+		start = Clock::now();
+		{
+			plycpp::AsyncLoader loader(options);
+			std::vector<std::future<plycpp::PLYData> > loads;
+			for (const std::string& filename : filenames)
+				loads.push_back(loader.load(filename));
+			for (auto& load : loads)
+				load.get();
+		}
+		const double asyncSeconds = secondsSince(start);
+
+		for (const std::string& filename : filenames)
+			std::remove(filename.c_str());
+
+		std::cout << "Loads of " << filesCount << " bunny files: sequential " << std::setprecision(0)
+			<< filesCount / sequentialSeconds << " files/s, asynchronous " << filesCount / asyncSeconds << " files/s" << std::endl;
+	}
+
+	size_t elementsCount(const plycpp::PLYData& data)
+	{
+		size_t count = 0;
+		for (const auto& element : data)
+			count += element.data->size();
+		return count;
+	}
+
+	/// Triangles as a face element of 'count' lists of three vertex indices
+	std::shared_ptr<plycpp::ElementArray> makeTriangles(const size_t count)
+	{
+		std::shared_ptr<plycpp::ElementArray> faces(new plycpp::ElementArray(count));
+		plycpp::PropertyArrayPtr indices(new plycpp::PropertyArray(typeid(int), 3 * count, true));
+		int* values = indices->ptr<int>();
+		for (size_t i = 0; i < 3 * count; ++i)
+			values[i] = static_cast<int>(i / 3 + i % 3);
+		faces->properties.push_back("vertex_indices", indices);
+		return faces;
+	}
+
+	/// Best time of 'runsCount' runs of 'function', in ns per element of the data it processes
+	template<typename Function>
+	void reportTimePerElement(const char* name, const size_t elementsCount, const int runsCount, const Function& function)
+	{
+		double best = 0.;
+		for (int run = 0; run < runsCount; ++run)
+		{
+			const Clock::time_point start = Clock::now();
+			function();
+			const double seconds = secondsSince(start);
+			if (run == 0 || seconds < best)
+				best = seconds;
+		}
+		std::cout << "* " << name << ": " << std::fixed << std::setprecision(1) << best * 1e9 / elementsCount << " ns/element" << std::endl;
+	}
+
+	/// Save and load elements through their decode and encode plans, including the small writes and reads of each value
+	void benchmarkPlans(const std::string& directory)
+	{
+		const std::string filename = directory + "/plycpp_benchmark_plans.ply";
+		std::cout << "Decode and encode plans, best of several runs" << std::endl;
+
+		plycpp::PLYData bunny;
+		plycpp::load(std::string(MODELS_DIRECTORY) + "/bunny.ply", bunny);
+		const size_t bunnyCount = elementsCount(bunny);
+		reportTimePerElement("binary save, bunny", bunnyCount, 20, [&]() { plycpp::save(filename, bunny, plycpp::FileFormat::BINARY); });
+		reportTimePerElement("binary big-endian save, bunny", bunnyCount, 20, [&]() { plycpp::save(filename, bunny, plycpp::FileFormat::BINARY_BIG_ENDIAN); });
+		reportTimePerElement("ASCII save, bunny", bunnyCount, 10, [&]() { plycpp::save(filename, bunny, plycpp::FileFormat::ASCII); });
+
+		const size_t facesCount = 2000000;
+		plycpp::PLYData faces;
+		faces.push_back("face", makeTriangles(facesCount));
+		reportTimePerElement("binary save, 2M faces", facesCount, 5, [&]() { plycpp::save(filename, faces, plycpp::FileFormat::BINARY); });
+		reportTimePerElement("binary list load, 2M faces", facesCount, 5, [&]() { plycpp::PLYData data; plycpp::load(filename, data); });
+		plycpp::save(filename, faces, plycpp::FileFormat::BINARY_BIG_ENDIAN);
+		reportTimePerElement("binary big-endian list load, 2M faces", facesCount, 5, [&]() { plycpp::PLYData data; plycpp::load(filename, data); });
+
+		std::remove(filename.c_str());
+	}
+}
+
+
+int main(int argc, char** argv)
+{
+	const size_t verticesCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+	const std::string directory = argc > 2 ? argv[2] : ".";
+	const unsigned int maxThreadsCount = argc > 3 ? static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10)) : std::max(1u, std::thread::hardware_concurrency());
+
+	bool success = true;
+	try
+	{
+		const std::string filename = directory + "/plycpp_benchmark.ply";
+		std::cout << "Writing " << verticesCount << " synthetic vertices..." << std::endl;
+		writeSyntheticFile(filename, verticesCount);
+		benchmarkBinaryLoad(filename, maxThreadsCount);
+		std::remove(filename.c_str());
+
+		// Odd counts exercise the tails of the vectorized kernels
+		const size_t packedCount = std::min<size_t>(verticesCount, 20000000) + 3;
+		std::cout << "Generic loop -> packProperties / unpackProperties" << std::endl;
+		success = benchmarkPacking<float, 3>("float", packedCount) && success;
+		success = benchmarkPacking<float, 4>("float", packedCount) && success;
+		success = benchmarkPacking<double, 3>("double", packedCount) && success;
+		success = benchmarkPacking<double, 4>("double", packedCount) && success;
+		success = benchmarkPacking<unsigned char, 3>("uchar", packedCount) && success;
+		success = benchmarkPacking<unsigned char, 4>("uchar", packedCount) && success;
+
+		benchmarkMemoryRoundTrip(std::min<size_t>(verticesCount, 20000000));
+		benchmarkAsyncLoads(directory, 200);
+		benchmarkPlans(directory);
+	}
+	catch (const plycpp::Exception& e)
+	{
+		std::cout << "An exception happened:\n" << e.what() << std::endl;
+		return 1;
+	}
+	return success ? 0 : 1;
+}
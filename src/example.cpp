@@ -65,6 +65,13 @@ void main()
 			std::cout << "\n";
 		}
 
+		// Access without sharing ownership, e.g. in tight loops
+		{
+			const plycpp::PropertyArray& yData = data.get("vertex").properties.get("y");
+			std::cout << "y value of the first vertex element:\n" << yData.at<float>(0) << std::endl;
+			std::cout << "\n";
+		}
+
 		// Example of raw pointer access
 		{
 			auto vertexElement = data["vertex"];
@@ -80,6 +87,18 @@ void main()
 			std::cout << "\n";
 		}
 
+		// Views iterate over properties without copying them, whatever their layout
+		{
+			const auto positions = data["vertex"]->view<float, 3>({ { "x", "y", "z" } });
+			std::cout << "Coordinates of the 5 first vertices, through a view:\n";
+			for (size_t i = 0; i < 5 && i < positions.size(); ++i)
+			{
+				const std::array<float, 3> p = positions[i];
+				std::cout << "* " << p[0] << " " << p[1] << " " << p[2] << std::endl;
+			}
+			std::cout << "\n";
+		}
+
 		// Helper functions to repack data
 		typedef std::vector<std::array<float, 3 > > Cloud;
 		Cloud points;
@@ -130,14 +149,14 @@ void main()
 			const auto& vertexIndicesData = data["face"]->properties["vertex_indices"];
 			if (vertexIndicesData && vertexIndicesData->isList)
 			{
-				// Only triplet lists are supported
-				assert(vertexIndicesData->size() % 3 == 0);
-				assert(vertexIndicesData->size() > 3);
-
-				std::cout << "Vertex indices of the first triangle:\n" << "* "
-					<< vertexIndicesData->at<int>(0) << " "
-					<< vertexIndicesData->at<int>(1) << " "
-					<< vertexIndicesData->at<int>(2) << std::endl;
+				// Lists may have any number of items
+				assert(vertexIndicesData->listsCount() > 0);
+
+				std::cout << "Vertex indices of the first face:\n" << "*";
+				const int* indices = vertexIndicesData->list<int>(0);
+				for (size_t i = 0; i < vertexIndicesData->listSize(0); ++i)
+					std::cout << " " << indices[i];
+				std::cout << std::endl;
 			}
 			else
 				std::cout << "No valid list of vertex indices." << std::endl;
@@ -24,11 +24,73 @@
 
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <unordered_map>
 #include <iostream>
 #include <cassert>
 #include <algorithm>
 #include <typeindex>
+#include <cstring>
+#include <cstdlib>
+#include <cctype>
+#include <cstdint>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <clocale>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+
+// Locale independent conversions between numbers and text (C++17)
+#if defined(__has_include)
+#if __has_include(<charconv>) && (__cplusplus >= 201703L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L))
+#include <charconv>
+#endif
+#endif
+#if defined(__cpp_lib_to_chars)
+#define PLYCPP_HAS_CHARCONV
+#endif
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PLYCPP_HAS_AVX2
+#endif
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PLYCPP_HAS_SSE2
+#endif
+#if defined(__SSSE3__) || defined(__AVX2__)
+#include <tmmintrin.h>
+#define PLYCPP_HAS_SSSE3
+#endif
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cerrno>
+#include <locale.h>
+#ifdef __APPLE__
+#include <xlocale.h>
+#endif
+#endif
+
+// Optional compression libraries, enabled by CMakeLists.txt when found
+#ifdef PLYCPP_HAS_ZLIB
+#include <zlib.h>
+#endif
+#ifdef PLYCPP_HAS_ZSTD
+#include <zstd.h>
+#endif
 
 namespace plycpp
 {
@@ -128,437 +190,4041 @@ namespace plycpp
 		return it->second;
 	}
 
+	template<typename T>
+	double loadAsDouble(const unsigned char* value)
+	{
+		T v;
+		std::memcpy(&v, value, sizeof(T));
+		return static_cast<double>(v);
+	}
 
-	PropertyArray::PropertyArray(const std::type_index type, const size_t size, const bool isList)
-		: type(type),
-		isList(isList),
-		stepSize(dataTypeToStepSize(type))
+	double valueAsDouble(const std::type_index& type, const unsigned char* value)
 	{
-		this->data.resize(size * this->stepSize);
+		if (type == FLOAT)
+			return loadAsDouble<float>(value);
+		else if (type == DOUBLE)
+			return loadAsDouble<double>(value);
+		else if (type == INT)
+			return loadAsDouble<int32_t>(value);
+		else if (type == UINT)
+			return loadAsDouble<uint32_t>(value);
+		else if (type == UCHAR)
+			return loadAsDouble<uint8_t>(value);
+		else if (type == CHAR)
+			return loadAsDouble<int8_t>(value);
+		else if (type == SHORT)
+			return loadAsDouble<int16_t>(value);
+		else if (type == USHORT)
+			return loadAsDouble<uint16_t>(value);
+		else
+			throw Exception("Invalid data type");
 	}
 
+	/// Decode the number of items of a list, stored with type T
+	typedef bool(*ListCountDecoder)(const unsigned char* ptData, size_t& count);
 
-	void splitString(const std::string& input, std::vector<std::string>& result)
-	{
-		result.clear();
-		std::stringstream ss(input);
-		while (true)
-		{
-			std::string elem;
-			ss >> elem;
-			if (ss.fail())
-				break;
-			result.push_back(elem);
-		}
+	/// Encode the number of items of a list with type T. Returns false if it does not fit.
+	typedef bool(*ListCountEncoder)(const size_t count, unsigned char* ptData);
 
+	template<typename T>
+	bool decodeListCount(const unsigned char* ptData, size_t& count)
+	{
+		T value;
+		std::memcpy(&value, ptData, sizeof(T));
+		if (static_cast<int64_t>(value) < 0)
+			return false;
+		count = static_cast<size_t>(value);
+		return true;
 	}
 
-	size_t strtol_except(const std::string& in)
+	template<typename T>
+	bool encodeListCount(const size_t count, unsigned char* ptData)
 	{
-		std::stringstream ss(in);
-		size_t val;
-		ss >> val;
-		if (ss.fail())
-			throw Exception("Invalid unsigned integer");
-		return val;
+		if (count > static_cast<size_t>(std::numeric_limits<T>::max()))
+			return false;
+		const T value = static_cast<T>(count);
+		std::memcpy(ptData, &value, sizeof(T));
+		return true;
 	}
 
+	ListCountDecoder getListCountDecoder(const std::type_index& type)
+	{
+		if (type == CHAR)
+			return &decodeListCount<int8_t>;
+		else if (type == UCHAR)
+			return &decodeListCount<uint8_t>;
+		else if (type == SHORT)
+			return &decodeListCount<int16_t>;
+		else if (type == USHORT)
+			return &decodeListCount<uint16_t>;
+		else if (type == INT)
+			return &decodeListCount<int32_t>;
+		else if (type == UINT)
+			return &decodeListCount<uint32_t>;
+		else
+			throw Exception("Invalid counting type for lists: " + dataTypeToString(type));
+	}
 
-	inline void readASCIIValue(std::ifstream& fin, unsigned char* const  ptData, const std::type_index& type)
+	ListCountEncoder getListCountEncoder(const std::type_index& type)
 	{
-		int temp;
 		if (type == CHAR)
-		{
-			fin >> temp;
-			*reinterpret_cast<int8_t*>(ptData) = static_cast<int8_t>(temp);
-		}
+			return &encodeListCount<int8_t>;
 		else if (type == UCHAR)
-		{
-			fin >> temp;
-			*reinterpret_cast<uint8_t*>(ptData) = static_cast<uint8_t>(temp);
-		}
+			return &encodeListCount<uint8_t>;
 		else if (type == SHORT)
-		{
-			fin >> *reinterpret_cast<int16_t*>(ptData);
-		}
+			return &encodeListCount<int16_t>;
 		else if (type == USHORT)
-		{
-			fin >> *reinterpret_cast<uint16_t*>(ptData);
-		}
+			return &encodeListCount<uint16_t>;
 		else if (type == INT)
-		{
-			fin >> *reinterpret_cast<int32_t*>(ptData);
-		}
+			return &encodeListCount<int32_t>;
 		else if (type == UINT)
+			return &encodeListCount<uint32_t>;
+		else
+			throw Exception("Invalid counting type for lists: " + dataTypeToString(type));
+	}
+
+
+	PropertyArray::PropertyArray(const std::type_index type, const size_t size, const bool isList)
+		: type(type),
+		isList(isList),
+		stepSize(dataTypeToStepSize(type)),
+		listCountType(UCHAR)
+	{
+		this->data.resize(size * this->stepSize);
+	}
+
+	void PropertyArray::setView(const std::shared_ptr<const void>& owner, const unsigned char* begin, const size_t stride, const size_t size)
+	{
+		std::vector<unsigned char>().swap(data);
+		viewOwner = owner;
+		viewData = begin;
+		viewStride = stride;
+		viewSize = size;
+		storageData = nullptr;
+	}
+
+	void PropertyArray::setStorage(const std::shared_ptr<void>& owner, unsigned char* begin, const size_t size)
+	{
+		assert(!isList);
+		setView(owner, begin, stepSize, size);
+		storageData = begin;
+	}
+
+	void PropertyArray::copyView()
+	{
+		std::vector<unsigned char> copy(viewSize * stepSize);
+		for (size_t i = 0; i < viewSize; ++i)
+			std::memcpy(&copy[i * stepSize], viewData + i * viewStride, stepSize);
+		data.swap(copy);
+		viewOwner.reset();
+		viewData = nullptr;
+		viewStride = 0;
+		viewSize = 0;
+	}
+
+	void ElementArray::setInterleavedRecords(const std::shared_ptr<const void>& owner, const unsigned char* records, const size_t recordSize)
+	{
+		size_t offset = 0;
+		for (auto& propertyTuple : properties)
 		{
-			fin >> *reinterpret_cast<uint32_t*>(ptData);
+			auto& prop = propertyTuple.data;
+			if (prop->isList)
+				throw Exception("Records with list properties cannot be interleaved");
+			prop->setView(owner, records + offset, recordSize, size_);
+			offset += prop->stepSize;
 		}
-		else if (type == FLOAT)
+		if (offset > recordSize)
+			throw Exception("Properties larger than their records");
+		recordsData = records;
+		recordSize_ = recordSize;
+	}
+
+	bool ElementArray::isInterleaved() const
+	{
+		if (!recordsData)
+			return false;
+		size_t offset = 0;
+		for (const auto& propertyTuple : properties)
 		{
-			fin >> *reinterpret_cast<float*>(ptData);
+			auto& prop = propertyTuple.data;
+			if (!prop->isView() || prop->bytes() != recordsData + offset || prop->stride() != recordSize_ || prop->size() != size_)
+				return false;
+			offset += prop->stepSize;
 		}
-		else if (type == DOUBLE)
+		return offset == recordSize_;
+	}
+
+	bool ElementArray::hasPropertyTypes(const std::vector<std::type_index>& types) const
+	{
+		auto itType = types.begin();
+		for (const auto& propertyTuple : properties)
 		{
-			fin >> *reinterpret_cast<double*>(ptData);
+			if (itType == types.end() || propertyTuple.data->isList || propertyTuple.data->type != *itType)
+				return false;
+			++itType;
 		}
-		else
-			throw Exception("Should not happen.");
+		return itType == types.end();
 	}
 
-	inline void writeASCIIValue(std::ofstream& fout, unsigned char* const  ptData, const std::type_index type)
+
+	/// Read-only memory mapping of a whole file
+	class MappedFile
 	{
-		if (type == CHAR)
+	public:
+		MappedFile(const std::string& filename)
 		{
-			fout << int(*reinterpret_cast<int8_t*>(ptData));
+#ifdef _WIN32
+			file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (file == INVALID_HANDLE_VALUE)
+				throw Exception(std::string("Unable to open ") + filename);
+			LARGE_INTEGER fileSize;
+			if (!GetFileSizeEx(file, &fileSize))
+			{
+				CloseHandle(file);
+				throw Exception(std::string("Unable to get the size of ") + filename);
+			}
+			size_ = static_cast<size_t>(fileSize.QuadPart);
+			if (size_ > 0)
+			{
+				mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (mapping != NULL)
+					data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+				if (data_ == nullptr)
+				{
+					if (mapping != NULL)
+						CloseHandle(mapping);
+					CloseHandle(file);
+					throw Exception(std::string("Unable to map ") + filename);
+				}
+			}
+#else
+			const int fd = open(filename.c_str(), O_RDONLY);
+			if (fd < 0)
+				throw Exception(std::string("Unable to open ") + filename);
+			struct stat st;
+			if (fstat(fd, &st) != 0)
+			{
+				close(fd);
+				throw Exception(std::string("Unable to get the size of ") + filename);
+			}
+			size_ = static_cast<size_t>(st.st_size);
+			if (size_ > 0)
+			{
+				void* address = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (address == MAP_FAILED)
+				{
+					close(fd);
+					throw Exception(std::string("Unable to map ") + filename);
+				}
+				data_ = static_cast<const unsigned char*>(address);
+			}
+			// The mapping remains valid once the file descriptor is closed
+			close(fd);
+#endif
 		}
-		else if (type == UCHAR)
+
+		~MappedFile()
 		{
-			fout << int(*reinterpret_cast<uint8_t*>(ptData));
+#ifdef _WIN32
+			if (data_)
+				UnmapViewOfFile(data_);
+			if (mapping != NULL)
+				CloseHandle(mapping);
+			CloseHandle(file);
+#else
+			if (data_)
+				munmap(const_cast<unsigned char*>(data_), size_);
+#endif
 		}
-		else if (type == SHORT)
+
+		const unsigned char* data() const
 		{
-			fout << *reinterpret_cast<int16_t*>(ptData);
+			return data_;
 		}
-		else if (type == USHORT)
+
+		size_t size() const
 		{
-			fout << *reinterpret_cast<uint16_t*>(ptData);
+			return size_;
 		}
-		else if (type == INT)
+
+	private:
+		MappedFile(const MappedFile&);
+		MappedFile& operator=(const MappedFile&);
+
+		const unsigned char* data_ = nullptr;
+		size_t size_ = 0;
+#ifdef _WIN32
+		HANDLE file = INVALID_HANDLE_VALUE;
+		HANDLE mapping = NULL;
+#endif
+	};
+
+	/// Stream buffer reading from a memory range without copying it
+	class MemoryStreamBuffer : public std::streambuf
+	{
+	public:
+		MemoryStreamBuffer(const unsigned char* begin, const size_t size)
 		{
-			fout << *reinterpret_cast<int32_t*>(ptData);
+			char* first = const_cast<char*>(reinterpret_cast<const char*>(begin));
+			setg(first, first, first + size);
 		}
-		else if (type == UINT)
+
+	protected:
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
 		{
-			fout << *reinterpret_cast<uint32_t*>(ptData);
+			if (!(which & std::ios_base::in))
+				return pos_type(off_type(-1));
+
+			off_type position = off;
+			if (dir == std::ios_base::cur)
+				position += gptr() - eback();
+			else if (dir == std::ios_base::end)
+				position += egptr() - eback();
+
+			if (position < 0 || position > egptr() - eback())
+				return pos_type(off_type(-1));
+			setg(eback(), eback() + position, egptr());
+			return pos_type(position);
 		}
-		else if (type == FLOAT)
+
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
 		{
-			fout << *reinterpret_cast<float*>(ptData);
+			return seekoff(off_type(pos), std::ios_base::beg, which);
 		}
-		else if (type == DOUBLE)
+
+		std::streamsize xsgetn(char* s, std::streamsize count) override
 		{
-			fout << *reinterpret_cast<double*>(ptData);
+			const std::streamsize available = egptr() - gptr();
+			const std::streamsize n = std::min(count, available);
+			std::memcpy(s, gptr(), static_cast<size_t>(n));
+			setg(eback(), gptr() + n, egptr());
+			return n;
 		}
-		else
-			throw Exception("Should not happen");
-	}
+	};
 
-	template <FileFormat format>
-	void readDataContent(std::ifstream& fin, PLYData& data)
+	/// Stream buffer appending to a growable buffer in memory
+	class VectorStreamBuffer : public std::streambuf
 	{
-		/// Store a pointer to the current place where to write next data for each property of each element
-		std::unordered_map<PropertyArray*, unsigned char*> writingPlace;
-		for (auto& elementTuple : data)
+	public:
+		VectorStreamBuffer(std::vector<unsigned char>& buffer)
+			: buffer(buffer)
+		{}
+
+	protected:
+		int_type overflow(int_type c) override
 		{
-			auto& element = elementTuple.data;
-			for (auto& propertyTuple : element->properties)
-			{
-				auto& prop = propertyTuple.data;
-				writingPlace[prop.get()] = prop->data.data();
-			}
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+				buffer.push_back(static_cast<unsigned char>(c));
+			return traits_type::not_eof(c);
 		}
 
-		//// Iterate over elements array
-		for (auto& elementArrayTuple : data)
+		std::streamsize xsputn(const char* s, std::streamsize count) override
 		{
-			auto& elementArray = elementArrayTuple.data;
-			const size_t elementsCount = elementArray->size();
-			// Iterate over elements
-			for (size_t i = 0; i < elementsCount; ++i)
-			{
-				// Iterate over properties of the element
-				for (auto& propertyTuple : elementArray->properties)
-				{
-					auto& prop = propertyTuple.data;
+			buffer.insert(buffer.end(), reinterpret_cast<const unsigned char*>(s), reinterpret_cast<const unsigned char*>(s) + count);
+			return count;
+		}
 
-					if (!prop->isList)
-					{
-						// Read data
-						auto& ptData = writingPlace[prop.get()];
-						// Safety check
-						assert(ptData >= prop->data.data());
-						assert(ptData + prop->stepSize <= prop->data.data() + prop->data.size());
+	private:
+		std::vector<unsigned char>& buffer;
+	};
 
-						if (format == ASCII)
-						{
-							readASCIIValue(fin, ptData, prop->type);
+	/// Size of the chunks of data compressed or decompressed at once
+	const size_t compressionChunkSize = 1 << 18;
 
-						}
-						else
-						{
-							fin.read(reinterpret_cast<char*>(ptData), prop->stepSize);
-						}
-						// Increment
-						ptData += prop->stepSize;
-					}
-					else
-					{
-						// Read count
-						uint8_t count;
+	/// Stream buffer decompressing data read from another stream buffer, by chunks
+	class DecompressingStreamBuffer : public std::streambuf
+	{
+	public:
+		DecompressingStreamBuffer(std::streambuf& source)
+			: source(source),
+			input(compressionChunkSize),
+			output(compressionChunkSize)
+		{}
 
-						if (format == ASCII)
-						{
-							int temp;
-							fin >> temp;
-							count = static_cast<unsigned char>(temp);
-						}
-						else
-						{
-							fin.read(reinterpret_cast<char*>(&count), sizeof(count));
-						}
-						if (fin.fail() || count != 3)
-						{
-							throw Exception("Only lists of 3 values are supported");
-						}
+		virtual ~DecompressingStreamBuffer()
+		{}
 
-						// Read data
-						auto& ptData = writingPlace[prop.get()];
-						const size_t chunkSize = 3 * prop->stepSize;
+	protected:
+		/// Only reports the current position in the decompressed data, which cannot be sought
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+		{
+			if (off != 0 || dir != std::ios_base::cur || !(which & std::ios_base::in))
+				return pos_type(off_type(-1));
+			return pos_type(static_cast<off_type>(decompressedSize) - (egptr() - gptr()));
+		}
 
-						// Safety check
-						assert(ptData >= prop->data.data());
-						assert(ptData + chunkSize <= prop->data.data() + prop->data.size());
+		/// Decompress at most 'inputSize' bytes of 'input' into at most 'outputSize' bytes of 'output'.
+		/// Returns false if the data is corrupted.
+		virtual bool decompress(const char* input, const size_t inputSize, size_t& consumed, char* output, const size_t outputSize, size_t& produced) = 0;
 
-						if (format == ASCII)
-						{
-							readASCIIValue(fin, ptData, prop->type);
-							ptData += prop->stepSize;
-							readASCIIValue(fin, ptData, prop->type);
-							ptData += prop->stepSize;
-							readASCIIValue(fin, ptData, prop->type);
-							ptData += prop->stepSize;
-						}
-						else
-						{
-							fin.read(reinterpret_cast<char*>(ptData), chunkSize);
-							ptData += chunkSize;
-						}
-					}
+		int_type underflow() override
+		{
+			while (!failed)
+			{
+				// Data remaining in the decoder is decompressed before reading more input
+				if (inputPosition == inputEnd && !outputPending)
+				{
+					inputEnd = static_cast<size_t>(source.sgetn(input.data(), input.size()));
+					inputPosition = 0;
+					if (inputEnd == 0)
+						return traits_type::eof();
+				}
+
+				size_t consumed = 0;
+				size_t produced = 0;
+				failed = !decompress(&input[inputPosition], inputEnd - inputPosition, consumed, output.data(), output.size(), produced);
+				inputPosition += consumed;
+				outputPending = (produced == output.size());
+				decompressedSize += produced;
+				if (produced > 0)
+				{
+					setg(output.data(), output.data(), output.data() + produced);
+					return traits_type::to_int_type(output[0]);
 				}
+				if (consumed == 0 && inputPosition != inputEnd)
+					failed = true;
 			}
+			return traits_type::eof();
 		}
-	}
 
-	void myGetline(std::ifstream& fin, std::string& line)
-	{
-		std::getline(fin, line);
-		// Files created with Windows have a carriage return
-		if (!line.empty() && line.back() == '\r')
-			line.pop_back();
-	}
+	private:
+		std::streambuf& source;
+		std::vector<char> input;
+		std::vector<char> output;
+		size_t inputPosition = 0;
+		size_t inputEnd = 0;
+		bool outputPending = false;
+		bool failed = false;
+		/// Number of bytes decompressed so far
+		uint64_t decompressedSize = 0;
+	};
 
-	void load(const std::string& filename, PLYData& data)
+	/// Stream buffer compressing the data written into it to another stream buffer, by chunks
+	class CompressingStreamBuffer : public std::streambuf
 	{
-		// Read header and reserve memory
-		data.clear();
-		std::string format;
-		std::string version;
-
-		std::ifstream fin(filename, std::ios::binary);
-		//fin.sync_with_stdio(false);
+	public:
+		CompressingStreamBuffer(std::streambuf& sink)
+			: output(compressionChunkSize),
+			sink(sink),
+			input(compressionChunkSize)
+		{
+			setp(input.data(), input.data() + input.size());
+		}
 
-		if (!fin.is_open())
-			throw Exception(std::string("Unable to open ") + filename);
+		virtual ~CompressingStreamBuffer()
+		{}
 
-		std::string line;
-		myGetline(fin, line);
+		/// Compress the remaining data and end the compressed stream. Returns false on error.
+		bool finish()
+		{
+			return compressInput(true);
+		}
 
-		std::shared_ptr<ElementArray> currentElement = nullptr;
+	protected:
+		/// Compress 'size' bytes of 'input', ending the compressed stream if 'end' is set.
+		/// Compressed data is given to writeOutput. Returns false on error.
+		virtual bool compress(const char* input, const size_t size, const bool end) = 0;
 
-		if (line != "ply")
+		/// Write the 'size' first bytes of the output buffer to the sink
+		bool writeOutput(const size_t size)
 		{
-			throw Exception("Missing magic number ""ply""");
+			return sink.sputn(output.data(), static_cast<std::streamsize>(size)) == static_cast<std::streamsize>(size);
 		}
 
-		while (line != "end_header")
+		int_type overflow(int_type c) override
 		{
-			myGetline(fin, line);
-			if (fin.fail())
-				throw Exception("Header parsing exception");
-
-			std::vector<std::string> lineContent;
-			splitString(line, lineContent);
-
-			if (lineContent.size() == 3 && lineContent[0] == "format")
+			if (!compressInput(false))
+				return traits_type::eof();
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
 			{
-				format = lineContent[1];
-				version = lineContent[2];
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
 			}
-			if (lineContent.size() == 3 && lineContent[0] == "element")
-			{
-				// New element
-				const std::string& name = lineContent[1];
-				const size_t count = strtol_except(lineContent[2]);
+			return traits_type::not_eof(c);
+		}
 
-				currentElement.reset(new ElementArray(count));
+		std::vector<char> output;
 
-				data.push_back(name, currentElement);
-			}
-			else if (lineContent.size() == 3 && lineContent[0] == "property")
-			{
-				if (!currentElement)
-					throw Exception("Header issue!");
+	private:
+		bool compressInput(const bool end)
+		{
+			const bool success = compress(pbase(), static_cast<size_t>(pptr() - pbase()), end);
+			setp(input.data(), input.data() + input.size());
+			return success;
+		}
 
-				// New property
-				const std::type_index dataType = parseDataType(lineContent[1]);
-				const std::string& name = lineContent[2];
+		std::streambuf& sink;
+		std::vector<char> input;
+	};
 
-				std::shared_ptr<PropertyArray> newProperty(new PropertyArray(dataType, currentElement->size()));
-				currentElement->properties.push_back(name, newProperty);
-			}
-			else if (lineContent.size() == 5 && lineContent[0] == "property" && lineContent[1] == "list")
-			{
-				if (!currentElement)
-					throw Exception("Header issue!");
+#ifdef PLYCPP_HAS_ZLIB
+	class GzipDecompressingStreamBuffer : public DecompressingStreamBuffer
+	{
+	public:
+		GzipDecompressingStreamBuffer(std::streambuf& source)
+			: DecompressingStreamBuffer(source)
+		{
+			std::memset(&stream, 0, sizeof(stream));
+			// Automatic detection of gzip and zlib headers
+			if (inflateInit2(&stream, 15 + 32) != Z_OK)
+				throw Exception("Unable to initialize gzip decompression");
+		}
 
-				const std::type_index indexCountType = parseDataType(lineContent[2]);
-				const std::type_index dataType = parseDataType(lineContent[3]);
-				const std::string& name = lineContent[4];
+		~GzipDecompressingStreamBuffer()
+		{
+			inflateEnd(&stream);
+		}
 
-				if (indexCountType != UCHAR)
-					throw Exception("Only uchar is supported as counting type for lists");
+	protected:
+		bool decompress(const char* input, const size_t inputSize, size_t& consumed, char* output, const size_t outputSize, size_t& produced) override
+		{
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+			stream.avail_in = static_cast<uInt>(inputSize);
+			stream.next_out = reinterpret_cast<Bytef*>(output);
+			stream.avail_out = static_cast<uInt>(outputSize);
+			const int result = inflate(&stream, Z_NO_FLUSH);
+			consumed = inputSize - stream.avail_in;
+			produced = outputSize - stream.avail_out;
+			// Concatenated gzip members are decompressed one after the other
+			if (result == Z_STREAM_END)
+				return inflateReset(&stream) == Z_OK;
+			return result == Z_OK || result == Z_BUF_ERROR;
+		}
 
-				std::shared_ptr<PropertyArray> newProperty(new PropertyArray(dataType, 3 * currentElement->size(), true));
-				currentElement->properties.push_back(name, newProperty);
-			}
+	private:
+		z_stream stream;
+	};
 
+	class GzipCompressingStreamBuffer : public CompressingStreamBuffer
+	{
+	public:
+		GzipCompressingStreamBuffer(std::streambuf& sink, const CompressionOptions& options)
+			: CompressingStreamBuffer(sink)
+		{
+			std::memset(&stream, 0, sizeof(stream));
+			// gzip header rather than a zlib one
+			const int level = options.level == 0 ? Z_DEFAULT_COMPRESSION : options.level;
+			if (deflateInit2(&stream, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+				throw Exception("Unable to initialize gzip compression");
 		}
 
-		if (fin.fail())
+		~GzipCompressingStreamBuffer()
 		{
-			throw Exception("Issue while parsing header");
+			deflateEnd(&stream);
 		}
 
-
-		/////////////////////////////////////
-		// Read data
-		if (format == "ascii")
+	protected:
+		bool compress(const char* input, const size_t size, const bool end) override
 		{
-			readDataContent<FileFormat::ASCII>(fin, data);
-
-			if (fin.fail())
+			stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input));
+			stream.avail_in = static_cast<uInt>(size);
+			while (true)
 			{
-				throw Exception("Issue while parsing ascii data");
+				stream.next_out = reinterpret_cast<Bytef*>(output.data());
+				stream.avail_out = static_cast<uInt>(output.size());
+				const int result = deflate(&stream, end ? Z_FINISH : Z_NO_FLUSH);
+				if (result == Z_STREAM_ERROR || !writeOutput(output.size() - stream.avail_out))
+					return false;
+				if (end ? result == Z_STREAM_END : stream.avail_out != 0)
+					return true;
 			}
 		}
-		else
-		{
-			const bool isBigEndianArchitecture_ = isBigEndianArchitecture();
-			if (format != "binary_little_endian" && format != "binary_big_endian")
-				throw Exception("Unknown binary format");
 
+	private:
+		z_stream stream;
+	};
+#endif
 
-			if ((isBigEndianArchitecture_ && format != "binary_big_endian")
-				|| (!isBigEndianArchitecture_ && format != "binary_little_endian"))
-				throw Exception("Endianness conversion is not supported yet");
-
-			readDataContent<FileFormat::BINARY>(fin, data);
+#ifdef PLYCPP_HAS_ZSTD
+	class ZstdDecompressingStreamBuffer : public DecompressingStreamBuffer
+	{
+	public:
+		ZstdDecompressingStreamBuffer(std::streambuf& source)
+			: DecompressingStreamBuffer(source),
+			context(ZSTD_createDCtx())
+		{
+			if (!context)
+				throw Exception("Unable to initialize zstd decompression");
+		}
 
-			if (fin.fail())
-			{
-				throw Exception("Issue while parsing binary data");
-			}
+		~ZstdDecompressingStreamBuffer()
+		{
+			ZSTD_freeDCtx(context);
+		}
 
-			// Ensure we reached the end of file by trying to read a last char
-			char useless;
-			fin.read(&useless, 1);
-			if (!fin.eof())
-			{
-				throw Exception("End of file not reached at the end of parsing.");
-			}
+	protected:
+		bool decompress(const char* input, const size_t inputSize, size_t& consumed, char* output, const size_t outputSize, size_t& produced) override
+		{
+			ZSTD_inBuffer in = { input, inputSize, 0 };
+			ZSTD_outBuffer out = { output, outputSize, 0 };
+			// Concatenated frames are decompressed one after the other
+			const size_t result = ZSTD_decompressStream(context, &out, &in);
+			consumed = in.pos;
+			produced = out.pos;
+			return !ZSTD_isError(result);
 		}
-	}
 
+	private:
+		ZSTD_DCtx* context;
+	};
 
-	template<FileFormat format>
-	void writeDataContent(std::ofstream& fout, const PLYData& data)
+	class ZstdCompressingStreamBuffer : public CompressingStreamBuffer
 	{
-		/// Store a pointer to the current place from which to read next data for each property of each element
-		std::unordered_map<PropertyArray*, unsigned char*> readingPlace;
-		for (auto& elementTuple : data)
+	public:
+		ZstdCompressingStreamBuffer(std::streambuf& sink, const CompressionOptions& options)
+			: CompressingStreamBuffer(sink),
+			context(ZSTD_createCCtx())
 		{
-			auto& element = elementTuple.data;
-			for (auto& propertyTuple : element->properties)
+			if (!context)
+				throw Exception("Unable to initialize zstd compression");
+			if (options.level != 0)
+				ZSTD_CCtx_setParameter(context, ZSTD_c_compressionLevel, options.level);
+
+			// Ignored if libzstd was built without multithreading
+			const unsigned int threadsCount = options.threadsCount > 0 ? options.threadsCount : std::max(1u, std::thread::hardware_concurrency());
+			if (threadsCount > 1)
+				ZSTD_CCtx_setParameter(context, ZSTD_c_nbWorkers, static_cast<int>(threadsCount));
+		}
+
+		~ZstdCompressingStreamBuffer()
+		{
+			ZSTD_freeCCtx(context);
+		}
+
+	protected:
+		bool compress(const char* input, const size_t size, const bool end) override
+		{
+			ZSTD_inBuffer in = { input, size, 0 };
+			while (true)
+			{
+				ZSTD_outBuffer out = { output.data(), output.size(), 0 };
+				const size_t remaining = ZSTD_compressStream2(context, &out, &in, end ? ZSTD_e_end : ZSTD_e_continue);
+				if (ZSTD_isError(remaining) || !writeOutput(out.pos))
+					return false;
+				if (end ? remaining == 0 : in.pos == in.size)
+					return true;
+			}
+		}
+
+	private:
+		ZSTD_CCtx* context;
+	};
+#endif
+
+	bool isCompressionSupported(const Compression compression)
+	{
+		switch (compression)
+		{
+		case Compression::UNCOMPRESSED:
+			return true;
+#ifdef PLYCPP_HAS_ZLIB
+		case Compression::GZIP:
+			return true;
+#endif
+#ifdef PLYCPP_HAS_ZSTD
+		case Compression::ZSTD:
+			return true;
+#endif
+		default:
+			return false;
+		}
+	}
+
+	Compression compressionFromExtension(const std::string& filename)
+	{
+		auto endsWith = [&filename](const std::string& extension) {
+			return filename.size() >= extension.size() && filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+		};
+		if (endsWith(".gz"))
+			return Compression::GZIP;
+		if (endsWith(".zst"))
+			return Compression::ZSTD;
+		return Compression::UNCOMPRESSED;
+	}
+
+	/// Compression of PLY data, detected from its first byte: uncompressed data starts with "ply"
+	Compression detectCompression(const int firstByte)
+	{
+		if (firstByte == 0x1f)
+			return Compression::GZIP;
+		if (firstByte == 0x28)
+			return Compression::ZSTD;
+		return Compression::UNCOMPRESSED;
+	}
+
+	/// Readers relying on the offsets of the file (loadRange, PlyReader) cannot decompress it
+	void checkUncompressed(const int firstByte, const std::string& reader)
+	{
+		if (detectCompression(firstByte) != Compression::UNCOMPRESSED)
+			throw Exception(reader + " requires uncompressed files");
+	}
+
+	/// Error raised for a compression plycpp was built without
+	Exception unsupportedCompression(const Compression compression)
+	{
+		return Exception(std::string("plycpp was built without support for ") + (compression == Compression::GZIP ? "gzip" : "zstd") + " compressed data");
+	}
+
+	std::unique_ptr<DecompressingStreamBuffer> makeDecompressingStreamBuffer(const Compression compression, std::streambuf& source)
+	{
+		switch (compression)
+		{
+#ifdef PLYCPP_HAS_ZLIB
+		case Compression::GZIP:
+			return std::unique_ptr<DecompressingStreamBuffer>(new GzipDecompressingStreamBuffer(source));
+#endif
+#ifdef PLYCPP_HAS_ZSTD
+		case Compression::ZSTD:
+			return std::unique_ptr<DecompressingStreamBuffer>(new ZstdDecompressingStreamBuffer(source));
+#endif
+		default:
+			(void)source;
+			throw unsupportedCompression(compression);
+		}
+	}
+
+	std::unique_ptr<CompressingStreamBuffer> makeCompressingStreamBuffer(const CompressionOptions& options, std::streambuf& sink)
+	{
+		switch (options.compression)
+		{
+#ifdef PLYCPP_HAS_ZLIB
+		case Compression::GZIP:
+			return std::unique_ptr<CompressingStreamBuffer>(new GzipCompressingStreamBuffer(sink, options));
+#endif
+#ifdef PLYCPP_HAS_ZSTD
+		case Compression::ZSTD:
+			return std::unique_ptr<CompressingStreamBuffer>(new ZstdCompressingStreamBuffer(sink, options));
+#endif
+		default:
+			(void)sink;
+			throw unsupportedCompression(options.compression);
+		}
+	}
+
+#ifdef __linux__
+	/// Size of the blocks read or written at once by the direct I/O backend
+	const size_t directIOBlockSize = 1 << 22;
+	/// Alignment of the buffers, offsets and sizes of direct I/O
+	const size_t directIOAlignment = 4096;
+
+	/// Buffer of the direct I/O backend, aligned for O_DIRECT
+	class AlignedBuffer
+	{
+	public:
+		AlignedBuffer(const size_t size)
+		{
+			void* address = nullptr;
+			if (posix_memalign(&address, directIOAlignment, size) != 0)
+				throw std::bad_alloc();
+			data_ = static_cast<char*>(address);
+		}
+
+		~AlignedBuffer()
+		{
+			free(data_);
+		}
+
+		char* data() const
+		{
+			return data_;
+		}
+
+	private:
+		AlignedBuffer(const AlignedBuffer&);
+		AlignedBuffer& operator=(const AlignedBuffer&);
+
+		char* data_;
+	};
+
+	/// Open a file bypassing the page cache, or through it if the file system does not support O_DIRECT
+	int openDirect(const std::string& filename, const int flags)
+	{
+		int fd = open(filename.c_str(), flags | O_DIRECT, 0644);
+		if (fd < 0 && errno == EINVAL)
+			fd = open(filename.c_str(), flags, 0644);
+		return fd;
+	}
+
+	/// Stream buffer reading a file by large aligned blocks, the next block being read in the background
+	class DirectInputStreamBuffer : public std::streambuf
+	{
+	public:
+		DirectInputStreamBuffer(const std::string& filename)
+			: fd(openDirect(filename, O_RDONLY)),
+			firstBuffer(directIOBlockSize),
+			secondBuffer(directIOBlockSize),
+			front(firstBuffer.data()),
+			back(secondBuffer.data())
+		{
+			if (fd < 0)
+				throw Exception(std::string("Unable to open ") + filename);
+			posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+			startRead(0);
+		}
+
+		~DirectInputStreamBuffer()
+		{
+			if (pending.valid())
+				pending.wait();
+			close(fd);
+		}
+
+	protected:
+		int_type underflow() override
+		{
+			if (gptr() == egptr() && !nextBlock())
+				return traits_type::eof();
+			return traits_type::to_int_type(*gptr());
+		}
+
+		pos_type seekoff(off_type off, std::ios_base::seekdir dir, std::ios_base::openmode which) override
+		{
+			if (!(which & std::ios_base::in) || dir == std::ios_base::end)
+				return pos_type(off_type(-1));
+
+			const off_type current = static_cast<off_type>(frontOffset) + (gptr() - eback());
+			const off_type position = (dir == std::ios_base::cur) ? current + off : off;
+			if (position < 0)
+				return pos_type(off_type(-1));
+
+			// Within the current block
+			const off_type begin = static_cast<off_type>(frontOffset);
+			if (position >= begin && position <= begin + (egptr() - eback()))
+			{
+				setg(eback(), eback() + (position - begin), egptr());
+				return pos_type(position);
+			}
+
+			// Restart reading at the block containing the position
+			if (pending.valid())
+				pending.wait();
+			const uint64_t blockOffset = static_cast<uint64_t>(position) / directIOAlignment * directIOAlignment;
+			startRead(blockOffset);
+			if (!nextBlock() || position > static_cast<off_type>(blockOffset) + (egptr() - eback()))
+			{
+				setg(front, front, front);
+				return pos_type(off_type(-1));
+			}
+			setg(eback(), eback() + (position - static_cast<off_type>(blockOffset)), egptr());
+			return pos_type(position);
+		}
+
+		pos_type seekpos(pos_type pos, std::ios_base::openmode which) override
+		{
+			return seekoff(off_type(pos), std::ios_base::beg, which);
+		}
+
+	private:
+		DirectInputStreamBuffer(const DirectInputStreamBuffer&);
+		DirectInputStreamBuffer& operator=(const DirectInputStreamBuffer&);
+
+		/// Start reading the block at 'offset' into the back buffer
+		void startRead(const uint64_t offset)
+		{
+			const int file = fd;
+			char* buffer = back;
+			pendingOffset = offset;
+			pending = std::async(std::launch::async, [file, buffer, offset]() {
+				size_t done = 0;
+				// Short reads only happen at the end of the file, or leave an aligned offset to continue from
+				while (done < directIOBlockSize && done % directIOAlignment == 0)
+				{
+					const ssize_t n = pread(file, buffer + done, directIOBlockSize - done, static_cast<off_t>(offset + done));
+					if (n < 0 && errno == EINTR)
+						continue;
+					if (n < 0)
+						return static_cast<ssize_t>(-1);
+					if (n == 0)
+						break;
+					done += static_cast<size_t>(n);
+				}
+				return static_cast<ssize_t>(done);
+			});
+		}
+
+		/// Make the block read in the background the current one, and start reading the following one
+		bool nextBlock()
+		{
+			if (!pending.valid())
+				return false;
+			const ssize_t size = pending.get();
+			if (size <= 0)
+				return false;
+			std::swap(front, back);
+			frontOffset = pendingOffset;
+			setg(front, front, front + size);
+			if (static_cast<size_t>(size) == directIOBlockSize)
+				startRead(pendingOffset + directIOBlockSize);
+			return true;
+		}
+
+		int fd;
+		AlignedBuffer firstBuffer;
+		AlignedBuffer secondBuffer;
+		/// Buffer being consumed or filled, and buffer being read or written in the background
+		char* front;
+		char* back;
+		/// Offset in the file of the current block
+		uint64_t frontOffset = 0;
+		/// Offset in the file of the block being read
+		uint64_t pendingOffset = 0;
+		std::future<ssize_t> pending;
+	};
+
+	/// Stream buffer writing a file by large aligned blocks, each block being written in the background
+	class DirectOutputStreamBuffer : public std::streambuf
+	{
+	public:
+		DirectOutputStreamBuffer(const std::string& filename)
+			: fd(openDirect(filename, O_WRONLY | O_CREAT | O_TRUNC)),
+			firstBuffer(directIOBlockSize),
+			secondBuffer(directIOBlockSize),
+			front(firstBuffer.data()),
+			back(secondBuffer.data())
+		{
+			if (fd < 0)
+				throw Exception(std::string("Unable to open ") + filename);
+			setp(front, front + directIOBlockSize);
+		}
+
+		/// Without finish(), e.g. when saving throws, the file is still cut to the data written so far
+		~DirectOutputStreamBuffer()
+		{
+			if (pending.valid())
+				pending.wait();
+			if (fd >= 0)
+			{
+				// Errors cannot be reported from here
+				const bool truncated = (ftruncate(fd, static_cast<off_t>(offset)) == 0);
+				(void)truncated;
+				close(fd);
+			}
+		}
+
+		/// Write the remaining data, and set the size of the file. Returns false on error.
+		bool finish()
+		{
+			const bool written = writeFront(true) && waitPending();
+			// Even after a failed write, the padding of the last block is cut off
+			const bool truncated = (ftruncate(fd, static_cast<off_t>(offset)) == 0);
+			const bool closed = (close(fd) == 0);
+			fd = -1;
+			return written && truncated && closed;
+		}
+
+	protected:
+		int_type overflow(int_type c) override
+		{
+			if (!writeFront(false))
+				return traits_type::eof();
+			if (!traits_type::eq_int_type(c, traits_type::eof()))
+			{
+				*pptr() = traits_type::to_char_type(c);
+				pbump(1);
+			}
+			return traits_type::not_eof(c);
+		}
+
+	private:
+		DirectOutputStreamBuffer(const DirectOutputStreamBuffer&);
+		DirectOutputStreamBuffer& operator=(const DirectOutputStreamBuffer&);
+
+		bool waitPending()
+		{
+			return !pending.valid() || pending.get();
+		}
+
+		/// Write the current block in the background, and fill the other one.
+		/// The last block is padded to the alignment, the file being truncated to its actual size afterwards.
+		bool writeFront(const bool last)
+		{
+			if (!waitPending())
+				return false;
+			const size_t size = static_cast<size_t>(pptr() - pbase());
+			assert(last || size == directIOBlockSize);
+			(void)last;
+			const size_t paddedSize = (size + directIOAlignment - 1) / directIOAlignment * directIOAlignment;
+			std::memset(front + size, 0, paddedSize - size);
+
+			std::swap(front, back);
+			setp(front, front + directIOBlockSize);
+			if (paddedSize == 0)
+				return true;
+
+			const int file = fd;
+			const char* buffer = back;
+			const uint64_t blockOffset = offset;
+			offset += size;
+			pending = std::async(std::launch::async, [file, buffer, paddedSize, blockOffset]() {
+				size_t done = 0;
+				while (done < paddedSize)
+				{
+					const ssize_t n = pwrite(file, buffer + done, paddedSize - done, static_cast<off_t>(blockOffset + done));
+					if (n < 0 && errno == EINTR)
+						continue;
+					if (n <= 0)
+						return false;
+					done += static_cast<size_t>(n);
+				}
+				return true;
+			});
+			return true;
+		}
+
+		int fd;
+		AlignedBuffer firstBuffer;
+		AlignedBuffer secondBuffer;
+		/// Buffer being consumed or filled, and buffer being read or written in the background
+		char* front;
+		char* back;
+		/// Number of bytes of data given to the writer
+		uint64_t offset = 0;
+		std::future<bool> pending;
+	};
+#endif
+
+	/// Memory holding the whole content of a file
+	struct MemoryRange
+	{
+		std::shared_ptr<const void> owner;
+		const unsigned char* begin;
+		size_t size;
+	};
+
+
+	void splitString(const std::string& input, std::vector<std::string>& result)
+	{
+		result.clear();
+		const char* it = input.c_str();
+		const char* const end = it + input.size();
+		while (true)
+		{
+			while (it != end && std::isspace(static_cast<unsigned char>(*it)))
+				++it;
+			if (it == end)
+				break;
+			const char* elemBegin = it;
+			while (it != end && !std::isspace(static_cast<unsigned char>(*it)))
+				++it;
+			result.emplace_back(elemBegin, it);
+		}
+	}
+
+	size_t strtol_except(const std::string& in)
+	{
+		std::stringstream ss(in);
+		size_t val;
+		ss >> val;
+		if (ss.fail())
+			throw Exception("Invalid unsigned integer");
+		return val;
+	}
+
+
+	/// Locale used to parse and format floating point values independently of the global locale
+#ifdef _WIN32
+	_locale_t cNumericLocale()
+	{
+		static const _locale_t locale = _create_locale(LC_NUMERIC, "C");
+		return locale;
+	}
+#else
+	locale_t cNumericLocale()
+	{
+		static const locale_t locale = newlocale(LC_NUMERIC_MASK, "C", static_cast<locale_t>(0));
+		return locale;
+	}
+#endif
+
+	/// Parse an integer written in base 10. Negative values wrap around for unsigned types, as with std::istream.
+	template<typename T>
+	bool parseInteger(const char* it, const char* const end, T& value)
+	{
+		static_assert(sizeof(T) <= sizeof(uint32_t), "Unsupported integer type");
+
+		bool negative = false;
+		if (it != end && (*it == '-' || *it == '+'))
+		{
+			negative = (*it == '-');
+			++it;
+		}
+		if (it == end)
+			return false;
+
+		const uint64_t maxMagnitude = std::numeric_limits<T>::is_signed && negative
+			? uint64_t(std::numeric_limits<T>::max()) + 1
+			: uint64_t(std::numeric_limits<T>::max());
+		uint64_t magnitude = 0;
+		for (; it != end; ++it)
+		{
+			const unsigned int digit = static_cast<unsigned int>(*it - '0');
+			if (digit > 9)
+				return false;
+			magnitude = 10 * magnitude + digit;
+			if (magnitude > maxMagnitude)
+				return false;
+		}
+		value = static_cast<T>(negative ? 0 - magnitude : magnitude);
+		return true;
+	}
+
+	bool parseFloatingPointWithLocale(const char* begin, const char* const end, float& value)
+	{
+		char* parsed;
+#ifdef _WIN32
+		value = _strtof_l(begin, &parsed, cNumericLocale());
+#else
+		value = strtof_l(begin, &parsed, cNumericLocale());
+#endif
+		return parsed == end && begin != end && std::abs(value) != std::numeric_limits<float>::infinity();
+	}
+
+	bool parseFloatingPointWithLocale(const char* begin, const char* const end, double& value)
+	{
+		char* parsed;
+#ifdef _WIN32
+		value = _strtod_l(begin, &parsed, cNumericLocale());
+#else
+		value = strtod_l(begin, &parsed, cNumericLocale());
+#endif
+		return parsed == end && begin != end && std::abs(value) != std::numeric_limits<double>::infinity();
+	}
+
+	/// Whether a token starts with a digit or a decimal point, after an optional sign.
+	/// std::istream rejects "nan", "inf" and "infinity", which from_chars and strtod accept.
+	bool isDecimalNumberToken(const char* begin, const char* const end)
+	{
+		if (begin != end && (*begin == '+' || *begin == '-'))
+			++begin;
+		return begin != end && (std::isdigit(static_cast<unsigned char>(*begin)) || *begin == '.');
+	}
+
+	/// Parse a floating point value as std::istream would do in the "C" locale
+	template<typename T>
+	bool parseFloatingPoint(const char* begin, const char* const end, T& value)
+	{
+		if (!isDecimalNumberToken(begin, end))
+			return false;
+#ifdef PLYCPP_HAS_CHARCONV
+		const char* first = (begin != end && *begin == '+') ? begin + 1 : begin;
+		if (first != begin && first != end && *first == '-')
+			return false;
+		const std::from_chars_result result = std::from_chars(first, end, value);
+		if (result.ec == std::errc() && result.ptr == end)
+			return true;
+		// Let strtod handle out of range values
+		if (result.ec != std::errc::result_out_of_range)
+			return false;
+#endif
+		return parseFloatingPointWithLocale(begin, end, value);
+	}
+
+	/// Parse a token into the value pointed by ptData. Returns false if the token is invalid.
+	typedef bool(*ASCIIParser)(const char* begin, const char* end, unsigned char* ptData);
+
+	template<typename T>
+	bool parseASCIIInteger(const char* begin, const char* end, unsigned char* ptData)
+	{
+		return parseInteger(begin, end, *reinterpret_cast<T*>(ptData));
+	}
+
+	/// chars are read as integers, then truncated
+	template<typename T>
+	bool parseASCIIChar(const char* begin, const char* end, unsigned char* ptData)
+	{
+		int32_t temp;
+		if (!parseInteger(begin, end, temp))
+			return false;
+		*reinterpret_cast<T*>(ptData) = static_cast<T>(temp);
+		return true;
+	}
+
+	template<typename T>
+	bool parseASCIIFloatingPoint(const char* begin, const char* end, unsigned char* ptData)
+	{
+		return parseFloatingPoint(begin, end, *reinterpret_cast<T*>(ptData));
+	}
+
+	/// Parse the number of items of a list, into a size_t
+	bool parseASCIIListCount(const char* begin, const char* end, unsigned char* ptData)
+	{
+		uint32_t count;
+		if (begin == end || *begin == '-' || !parseInteger(begin, end, count))
+			return false;
+		*reinterpret_cast<size_t*>(ptData) = count;
+		return true;
+	}
+
+	ASCIIParser getASCIIParser(const std::type_index& type)
+	{
+		if (type == CHAR)
+			return &parseASCIIChar<int8_t>;
+		else if (type == UCHAR)
+			return &parseASCIIChar<uint8_t>;
+		else if (type == SHORT)
+			return &parseASCIIInteger<int16_t>;
+		else if (type == USHORT)
+			return &parseASCIIInteger<uint16_t>;
+		else if (type == INT)
+			return &parseASCIIInteger<int32_t>;
+		else if (type == UINT)
+			return &parseASCIIInteger<uint32_t>;
+		else if (type == FLOAT)
+			return &parseASCIIFloatingPoint<float>;
+		else if (type == DOUBLE)
+			return &parseASCIIFloatingPoint<double>;
+		else
+			throw Exception("Should not happen.");
+	}
+
+	/// Growable buffer whose new values are left uninitialized, unlike those of a std::vector
+	template<typename T>
+	class UninitializedBuffer
+	{
+	public:
+		explicit UninitializedBuffer(const size_t size)
+			: values(new T[size]),
+			size_(size)
+		{}
+
+		size_t size() const
+		{
+			return size_;
+		}
+
+		T* data()
+		{
+			return values.get();
+		}
+
+		T& operator[](const size_t i)
+		{
+			return values[i];
+		}
+
+		/// Change the size, keeping the first values
+		void resize(const size_t size)
+		{
+			std::unique_ptr<T[]> resized(new T[size]);
+			std::memcpy(resized.get(), values.get(), std::min(size, size_) * sizeof(T));
+			values.swap(resized);
+			size_ = size;
+		}
+
+	private:
+		std::unique_ptr<T[]> values;
+		size_t size_;
+	};
+
+	/// Split a stream into whitespace separated tokens, reading it by large chunks
+	class ASCIITokenizer
+	{
+	public:
+		ASCIITokenizer(std::istream& fin)
+			: fin(fin),
+			buffer(1 << 20)
+		{}
+
+		/// Get the next token. Returns false once the end of the stream is reached.
+		bool next(const char*& tokenBegin, const char*& tokenEnd)
+		{
+			while (true)
+			{
+				while (position < end && isSpace(buffer[position]))
+					++position;
+				if (position == end)
+				{
+					if (!refill())
+						return false;
+					continue;
+				}
+
+				size_t last = position;
+				while (last < end && !isSpace(buffer[last]))
+					++last;
+				// The token may continue in the next chunk
+				if (last == end && refill())
+					continue;
+
+				tokenBegin = &buffer[position];
+				tokenEnd = &buffer[last];
+				position = last;
+				return true;
+			}
+		}
+
+		/// Parse the next token with a given parser
+		bool read(const ASCIIParser parser, unsigned char* ptData)
+		{
+			const char* tokenBegin;
+			const char* tokenEnd;
+			return next(tokenBegin, tokenEnd) && parser(tokenBegin, tokenEnd, ptData);
+		}
+
+		/// Step over the next token without parsing it
+		bool skip()
+		{
+			const char* tokenBegin;
+			const char* tokenEnd;
+			return next(tokenBegin, tokenEnd);
+		}
+
+	private:
+		static bool isSpace(const char c)
+		{
+			return c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == '\v' || c == '\f';
+		}
+
+		/// Keep unread data at the front of the buffer and complete it from the stream.
+		/// Returns false if nothing more could be read.
+		bool refill()
+		{
+			if (endOfStream)
+				return false;
+
+			const size_t remaining = end - position;
+			std::memmove(buffer.data(), buffer.data() + position, remaining);
+			// Keep room for a terminating null character
+			if (remaining + 1 >= buffer.size())
+				buffer.resize(2 * buffer.size());
+
+			fin.read(buffer.data() + remaining, buffer.size() - 1 - remaining);
+			const size_t count = static_cast<size_t>(fin.gcount());
+			if (fin.eof())
+			{
+				// Reaching the end of the body is expected
+				endOfStream = true;
+				fin.clear(std::ios::eofbit);
+			}
+
+			position = 0;
+			end = remaining + count;
+			buffer[end] = '\0';
+			return count > 0;
+		}
+
+		std::istream& fin;
+		UninitializedBuffer<char> buffer;
+		size_t position = 0;
+		size_t end = 0;
+		bool endOfStream = false;
+	};
+
+	/// Maximum number of characters written by an ASCIIFormatter
+	const size_t maxASCIIValueLength = 32;
+
+	/// Write a value as text at 'out', and return the end of the written text
+	typedef char* (*ASCIIFormatter)(char* out, const unsigned char* ptData);
+
+	template<typename T>
+	char* formatInteger(char* out, const T value)
+	{
+		// Magnitude computed in 64 bits so that the minimum value of signed types can be negated
+		int64_t signedValue = static_cast<int64_t>(value);
+		if (signedValue < 0)
+		{
+			*out++ = '-';
+			signedValue = -signedValue;
+		}
+		uint64_t magnitude = static_cast<uint64_t>(signedValue);
+
+		char digits[20];
+		int count = 0;
+		do
+		{
+			digits[count++] = static_cast<char>('0' + magnitude % 10);
+			magnitude /= 10;
+		} while (magnitude != 0);
+		while (count > 0)
+			*out++ = digits[--count];
+		return out;
+	}
+
+	/// Format a floating point value with enough digits to be read back exactly
+	template<typename T>
+	char* formatFloatingPoint(char* out, const T value)
+	{
+#ifdef PLYCPP_HAS_CHARCONV
+		// Shortest representation that round-trips
+		return std::to_chars(out, out + maxASCIIValueLength, value).ptr;
+#else
+		const char* format = sizeof(T) == sizeof(float) ? "%.9g" : "%.17g";
+#ifdef _WIN32
+		const int length = _snprintf_l(out, maxASCIIValueLength, format, cNumericLocale(), static_cast<double>(value));
+#else
+		const locale_t previousLocale = uselocale(cNumericLocale());
+		const int length = snprintf(out, maxASCIIValueLength, format, static_cast<double>(value));
+		uselocale(previousLocale);
+#endif
+		return out + length;
+#endif
+	}
+
+	template<typename T>
+	char* formatASCIIInteger(char* out, const unsigned char* ptData)
+	{
+		return formatInteger(out, *reinterpret_cast<const T*>(ptData));
+	}
+
+	template<typename T>
+	char* formatASCIIFloatingPoint(char* out, const unsigned char* ptData)
+	{
+		return formatFloatingPoint(out, *reinterpret_cast<const T*>(ptData));
+	}
+
+	ASCIIFormatter getASCIIFormatter(const std::type_index& type)
+	{
+		if (type == CHAR)
+			return &formatASCIIInteger<int8_t>;
+		else if (type == UCHAR)
+			return &formatASCIIInteger<uint8_t>;
+		else if (type == SHORT)
+			return &formatASCIIInteger<int16_t>;
+		else if (type == USHORT)
+			return &formatASCIIInteger<uint16_t>;
+		else if (type == INT)
+			return &formatASCIIInteger<int32_t>;
+		else if (type == UINT)
+			return &formatASCIIInteger<uint32_t>;
+		else if (type == FLOAT)
+			return &formatASCIIFloatingPoint<float>;
+		else if (type == DOUBLE)
+			return &formatASCIIFloatingPoint<double>;
+		else
+			throw Exception("Should not happen");
+	}
+
+	/// Accumulate text in a large buffer, written to the stream by big chunks
+	class ASCIIWriter
+	{
+	public:
+		ASCIIWriter(std::ostream& fout)
+			: fout(fout),
+			buffer(1 << 20)
+		{}
+
+		~ASCIIWriter()
+		{
+			flush();
+		}
+
+		/// Write a value followed by a space
+		void write(const ASCIIFormatter formatter, const unsigned char* ptData)
+		{
+			reserve(maxASCIIValueLength + 1);
+			char* out = formatter(&buffer[position], ptData);
+			*out++ = ' ';
+			position = out - buffer.data();
+		}
+
+		void put(const char c)
+		{
+			reserve(1);
+			buffer[position++] = c;
+		}
+
+		void flush()
+		{
+			fout.write(buffer.data(), position);
+			position = 0;
+		}
+
+	private:
+		void reserve(const size_t size)
+		{
+			if (position + size > buffer.size())
+				flush();
+		}
+
+		std::ostream& fout;
+		UninitializedBuffer<char> buffer;
+		size_t position = 0;
+	};
+
+	/// Threads created once per load, which run batches of tasks taken from a shared queue.
+	/// The calling thread takes part in each batch, so that a pool of one thread creates none.
+	class WorkerPool
+	{
+	public:
+		explicit WorkerPool(const size_t threadsCount)
+		{
+			for (size_t t = 1; t < threadsCount; ++t)
+				workers.push_back(std::thread([this]() { work(); }));
+		}
+
+		~WorkerPool()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			started.notify_all();
+			for (auto& worker : workers)
+				worker.join();
+		}
+
+		/// Number of threads running the tasks, the calling one included
+		size_t size() const
+		{
+			return workers.size() + 1;
+		}
+
+		/// Run function(task) for each task of [0, tasksCount), wait for all of them and forward the first exception raised
+		void run(const size_t tasksCount, const std::function<void(size_t)>& function)
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				batch = &function;
+				nextTask = 0;
+				batchSize = tasksCount;
+				pendingTasks = tasksCount;
+				errors.assign(tasksCount, std::exception_ptr());
+			}
+			started.notify_all();
+			runTasks();
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				finished.wait(lock, [this]() { return pendingTasks == 0; });
+				batch = nullptr;
+			}
+			for (auto& error : errors)
+			{
+				if (error)
+					std::rethrow_exception(error);
+			}
+		}
+
+	private:
+		WorkerPool(const WorkerPool&);
+		WorkerPool& operator=(const WorkerPool&);
+
+		void work()
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			while (true)
+			{
+				started.wait(lock, [this]() { return stopping || nextTask < batchSize; });
+				if (stopping)
+					return;
+				lock.unlock();
+				runTasks();
+				lock.lock();
+			}
+		}
+
+		/// Take tasks from the current batch until none is left
+		void runTasks()
+		{
+			while (true)
+			{
+				size_t task;
+				const std::function<void(size_t)>* function;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					if (nextTask >= batchSize)
+						return;
+					task = nextTask++;
+					function = batch;
+				}
+				try
+				{
+					(*function)(task);
+				}
+				catch (...)
+				{
+					errors[task] = std::current_exception();
+				}
+				std::lock_guard<std::mutex> lock(mutex);
+				if (--pendingTasks == 0)
+					finished.notify_all();
+			}
+		}
+
+		std::vector<std::thread> workers;
+		std::mutex mutex;
+		std::condition_variable started;
+		std::condition_variable finished;
+		const std::function<void(size_t)>* batch = nullptr;
+		size_t nextTask = 0;
+		size_t batchSize = 0;
+		size_t pendingTasks = 0;
+		std::vector<std::exception_ptr> errors;
+		bool stopping = false;
+	};
+
+	inline uint16_t byteSwap(const uint16_t v)
+	{
+		return static_cast<uint16_t>((v >> 8) | (v << 8));
+	}
+
+	inline uint32_t byteSwap(const uint32_t v)
+	{
+		return (v >> 24) | ((v >> 8) & 0x0000FF00u) | ((v << 8) & 0x00FF0000u) | (v << 24);
+	}
+
+	inline uint64_t byteSwap(const uint64_t v)
+	{
+		return (uint64_t(byteSwap(static_cast<uint32_t>(v))) << 32) | byteSwap(static_cast<uint32_t>(v >> 32));
+	}
+
+	/// Reverse in place the bytes of 'count' consecutive values of type T
+	template<typename T>
+	void byteSwapValues(unsigned char* data, const size_t count)
+	{
+		size_t i = 0;
+#if defined(PLYCPP_HAS_AVX2)
+		const __m256i mask = sizeof(T) == 2
+			? _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14)
+			: sizeof(T) == 4
+			? _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12)
+			: _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+		const size_t valuesPerVector = 32 / sizeof(T);
+		for (; i + valuesPerVector <= count; i += valuesPerVector)
+		{
+			__m256i* pt = reinterpret_cast<__m256i*>(data + i * sizeof(T));
+			_mm256_storeu_si256(pt, _mm256_shuffle_epi8(_mm256_loadu_si256(pt), mask));
+		}
+#elif defined(PLYCPP_HAS_SSE2)
+		const size_t valuesPerVector = 16 / sizeof(T);
+		for (; i + valuesPerVector <= count; i += valuesPerVector)
+		{
+			__m128i* pt = reinterpret_cast<__m128i*>(data + i * sizeof(T));
+			__m128i v = _mm_loadu_si128(pt);
+			// Reverse the 16 bits words of each value, then the bytes of each word
+			if (sizeof(T) == 4)
+				v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(2, 3, 0, 1)), _MM_SHUFFLE(2, 3, 0, 1));
+			else if (sizeof(T) == 8)
+				v = _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(0, 1, 2, 3)), _MM_SHUFFLE(0, 1, 2, 3));
+			v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+			_mm_storeu_si128(pt, v);
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			T value;
+			std::memcpy(&value, data + i * sizeof(T), sizeof(T));
+			value = byteSwap(value);
+			std::memcpy(data + i * sizeof(T), &value, sizeof(T));
+		}
+	}
+
+	/// Reverse in place the bytes of 'count' consecutive values of 'stepSize' bytes
+	void byteSwapValues(unsigned char* data, const size_t count, const size_t stepSize)
+	{
+		switch (stepSize)
+		{
+		case 1:
+			break;
+		case 2:
+			byteSwapValues<uint16_t>(data, count);
+			break;
+		case 4:
+			byteSwapValues<uint32_t>(data, count);
+			break;
+		case 8:
+			byteSwapValues<uint64_t>(data, count);
+			break;
+		default:
+			throw Exception("Should not happen.");
+		}
+	}
+
+	/// Reverse in place the bytes of 'count' values of type T, 'stride' bytes apart
+	template<typename T>
+	void byteSwapStridedValues(unsigned char* data, const size_t count, const size_t stride)
+	{
+		for (size_t i = 0; i < count; ++i, data += stride)
+		{
+			T value;
+			std::memcpy(&value, data, sizeof(T));
+			value = byteSwap(value);
+			std::memcpy(data, &value, sizeof(T));
+		}
+	}
+
+	/// Reverse in place the bytes of 'count' values of 'stepSize' bytes, 'stride' bytes apart
+	void byteSwapStridedValues(unsigned char* data, const size_t count, const size_t stepSize, const size_t stride)
+	{
+		switch (stepSize)
+		{
+		case 1:
+			break;
+		case 2:
+			byteSwapStridedValues<uint16_t>(data, count, stride);
+			break;
+		case 4:
+			byteSwapStridedValues<uint32_t>(data, count, stride);
+			break;
+		case 8:
+			byteSwapStridedValues<uint64_t>(data, count, stride);
+			break;
+		default:
+			throw Exception("Should not happen.");
+		}
+	}
+
+	/// Interleave the values of Channels arrays, from the i-th value of each array to 'count'
+	template<size_t ValueSize, size_t Channels>
+	void packValues(const unsigned char* const* channels, size_t i, const size_t count, unsigned char* output)
+	{
+		// Local copy of the pointers, which cannot alias the output
+		const unsigned char* ptChannels[Channels];
+		std::copy(channels, channels + Channels, ptChannels);
+		for (; i < count; ++i)
+		{
+			for (size_t j = 0; j < Channels; ++j)
+				std::memcpy(output + (i * Channels + j) * ValueSize, ptChannels[j] + i * ValueSize, ValueSize);
+		}
+	}
+
+	/// Dispatch interleaved values into Channels arrays, from the i-th value of each array to 'count'
+	template<size_t ValueSize, size_t Channels>
+	void unpackValues(const unsigned char* input, size_t i, const size_t count, unsigned char* const* channels)
+	{
+		// Local copy of the pointers, which cannot alias the outputs
+		unsigned char* ptChannels[Channels];
+		std::copy(channels, channels + Channels, ptChannels);
+		for (; i < count; ++i)
+		{
+			for (size_t j = 0; j < Channels; ++j)
+				std::memcpy(ptChannels[j] + i * ValueSize, input + (i * Channels + j) * ValueSize, ValueSize);
+		}
+	}
+
+	/// Vectorized kernels for 3 or 4 channels of 1, 4 or 8 bytes values.
+	/// Each returns the number of values processed, the remaining ones being left to the generic loops.
+	/// Packing 8 bytes values is bound by memory, and is left to the generic loops.
+#if defined(PLYCPP_HAS_SSE2)
+	size_t packValues4x3(const unsigned char* const* channels, const size_t count, unsigned char* output)
+	{
+		const float* x = reinterpret_cast<const float*>(channels[0]);
+		const float* y = reinterpret_cast<const float*>(channels[1]);
+		const float* z = reinterpret_cast<const float*>(channels[2]);
+		float* out = reinterpret_cast<float*>(output);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 vx = _mm_loadu_ps(x + i);
+			const __m128 vy = _mm_loadu_ps(y + i);
+			const __m128 vz = _mm_loadu_ps(z + i);
+			const __m128 xyLow = _mm_unpacklo_ps(vx, vy);
+			const __m128 xyHigh = _mm_unpackhi_ps(vx, vy);
+			const __m128 zx = _mm_shuffle_ps(vz, vx, _MM_SHUFFLE(1, 1, 0, 0));
+			const __m128 yz = _mm_shuffle_ps(vy, vz, _MM_SHUFFLE(1, 1, 1, 1));
+			const __m128 zxHigh = _mm_shuffle_ps(vz, xyHigh, _MM_SHUFFLE(2, 2, 2, 2));
+			const __m128 yzHigh = _mm_shuffle_ps(xyHigh, vz, _MM_SHUFFLE(3, 3, 3, 3));
+			_mm_storeu_ps(out + 3 * i, _mm_shuffle_ps(xyLow, zx, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(out + 3 * i + 4, _mm_shuffle_ps(yz, xyHigh, _MM_SHUFFLE(1, 0, 2, 0)));
+			_mm_storeu_ps(out + 3 * i + 8, _mm_shuffle_ps(zxHigh, yzHigh, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+		return i;
+	}
+
+	size_t unpackValues4x3(const unsigned char* input, const size_t count, unsigned char* const* channels)
+	{
+		const float* in = reinterpret_cast<const float*>(input);
+		float* x = reinterpret_cast<float*>(channels[0]);
+		float* y = reinterpret_cast<float*>(channels[1]);
+		float* z = reinterpret_cast<float*>(channels[2]);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const __m128 in0 = _mm_loadu_ps(in + 3 * i);
+			const __m128 in1 = _mm_loadu_ps(in + 3 * i + 4);
+			const __m128 in2 = _mm_loadu_ps(in + 3 * i + 8);
+			const __m128 x01 = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(2, 2, 3, 0));
+			const __m128 x23 = _mm_shuffle_ps(in1, in2, _MM_SHUFFLE(1, 1, 2, 2));
+			const __m128 y01 = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(0, 0, 0, 1));
+			const __m128 y23 = _mm_shuffle_ps(in1, in2, _MM_SHUFFLE(2, 2, 3, 3));
+			const __m128 z01 = _mm_shuffle_ps(in0, in1, _MM_SHUFFLE(1, 1, 2, 2));
+			const __m128 z23 = _mm_shuffle_ps(in2, in2, _MM_SHUFFLE(3, 3, 0, 0));
+			_mm_storeu_ps(x + i, _mm_shuffle_ps(x01, x23, _MM_SHUFFLE(2, 0, 1, 0)));
+			_mm_storeu_ps(y + i, _mm_shuffle_ps(y01, y23, _MM_SHUFFLE(2, 0, 2, 0)));
+			_mm_storeu_ps(z + i, _mm_shuffle_ps(z01, z23, _MM_SHUFFLE(2, 0, 2, 0)));
+		}
+		return i;
+	}
+
+	size_t packValues4x4(const unsigned char* const* channels, const size_t count, unsigned char* output)
+	{
+		float* out = reinterpret_cast<float*>(output);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v0 = _mm_loadu_ps(reinterpret_cast<const float*>(channels[0]) + i);
+			__m128 v1 = _mm_loadu_ps(reinterpret_cast<const float*>(channels[1]) + i);
+			__m128 v2 = _mm_loadu_ps(reinterpret_cast<const float*>(channels[2]) + i);
+			__m128 v3 = _mm_loadu_ps(reinterpret_cast<const float*>(channels[3]) + i);
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps(out + 4 * i, v0);
+			_mm_storeu_ps(out + 4 * i + 4, v1);
+			_mm_storeu_ps(out + 4 * i + 8, v2);
+			_mm_storeu_ps(out + 4 * i + 12, v3);
+		}
+		return i;
+	}
+
+	size_t unpackValues4x4(const unsigned char* input, const size_t count, unsigned char* const* channels)
+	{
+		const float* in = reinterpret_cast<const float*>(input);
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 v0 = _mm_loadu_ps(in + 4 * i);
+			__m128 v1 = _mm_loadu_ps(in + 4 * i + 4);
+			__m128 v2 = _mm_loadu_ps(in + 4 * i + 8);
+			__m128 v3 = _mm_loadu_ps(in + 4 * i + 12);
+			_MM_TRANSPOSE4_PS(v0, v1, v2, v3);
+			_mm_storeu_ps(reinterpret_cast<float*>(channels[0]) + i, v0);
+			_mm_storeu_ps(reinterpret_cast<float*>(channels[1]) + i, v1);
+			_mm_storeu_ps(reinterpret_cast<float*>(channels[2]) + i, v2);
+			_mm_storeu_ps(reinterpret_cast<float*>(channels[3]) + i, v3);
+		}
+		return i;
+	}
+
+	size_t unpackValues8x3(const unsigned char* input, const size_t count, unsigned char* const* channels)
+	{
+		const double* in = reinterpret_cast<const double*>(input);
+		double* x = reinterpret_cast<double*>(channels[0]);
+		double* y = reinterpret_cast<double*>(channels[1]);
+		double* z = reinterpret_cast<double*>(channels[2]);
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m128d in0 = _mm_loadu_pd(in + 3 * i);
+			const __m128d in1 = _mm_loadu_pd(in + 3 * i + 2);
+			const __m128d in2 = _mm_loadu_pd(in + 3 * i + 4);
+			_mm_storeu_pd(x + i, _mm_shuffle_pd(in0, in1, 2));
+			_mm_storeu_pd(y + i, _mm_shuffle_pd(in0, in2, 1));
+			_mm_storeu_pd(z + i, _mm_shuffle_pd(in1, in2, 2));
+		}
+		return i;
+	}
+
+	size_t unpackValues8x4(const unsigned char* input, const size_t count, unsigned char* const* channels)
+	{
+		const double* in = reinterpret_cast<const double*>(input);
+		size_t i = 0;
+		for (; i + 2 <= count; i += 2)
+		{
+			const __m128d in0 = _mm_loadu_pd(in + 4 * i);
+			const __m128d in1 = _mm_loadu_pd(in + 4 * i + 2);
+			const __m128d in2 = _mm_loadu_pd(in + 4 * i + 4);
+			const __m128d in3 = _mm_loadu_pd(in + 4 * i + 6);
+			_mm_storeu_pd(reinterpret_cast<double*>(channels[0]) + i, _mm_unpacklo_pd(in0, in2));
+			_mm_storeu_pd(reinterpret_cast<double*>(channels[1]) + i, _mm_unpackhi_pd(in0, in2));
+			_mm_storeu_pd(reinterpret_cast<double*>(channels[2]) + i, _mm_unpacklo_pd(in1, in3));
+			_mm_storeu_pd(reinterpret_cast<double*>(channels[3]) + i, _mm_unpackhi_pd(in1, in3));
+		}
+		return i;
+	}
+
+	size_t packValues1x4(const unsigned char* const* channels, const size_t count, unsigned char* output)
+	{
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i r = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[0] + i));
+			const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[1] + i));
+			const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[2] + i));
+			const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[3] + i));
+			const __m128i rgLow = _mm_unpacklo_epi8(r, g);
+			const __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+			const __m128i baLow = _mm_unpacklo_epi8(b, a);
+			const __m128i baHigh = _mm_unpackhi_epi8(b, a);
+			__m128i* out = reinterpret_cast<__m128i*>(output + 4 * i);
+			_mm_storeu_si128(out, _mm_unpacklo_epi16(rgLow, baLow));
+			_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(rgLow, baLow));
+			_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(rgHigh, baHigh));
+			_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(rgHigh, baHigh));
+		}
+		return i;
+	}
+
+	size_t unpackValues1x4(const unsigned char* input, const size_t count, unsigned char* const* channels)
+	{
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			const __m128i* in = reinterpret_cast<const __m128i*>(input + 4 * i);
+			const __m128i in0 = _mm_loadu_si128(in);
+			const __m128i in1 = _mm_loadu_si128(in + 1);
+			const __m128i in2 = _mm_loadu_si128(in + 2);
+			const __m128i in3 = _mm_loadu_si128(in + 3);
+			// Isolate each channel in 32 bits words, then narrow them to bytes
+			for (int j = 0; j < 4; ++j)
+			{
+				const __m128i shift = _mm_cvtsi32_si128(8 * j);
+				const __m128i low = _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(in0, shift), byteMask), _mm_and_si128(_mm_srl_epi32(in1, shift), byteMask));
+				const __m128i high = _mm_packs_epi32(_mm_and_si128(_mm_srl_epi32(in2, shift), byteMask), _mm_and_si128(_mm_srl_epi32(in3, shift), byteMask));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(channels[j] + i), _mm_packus_epi16(low, high));
+			}
+		}
+		return i;
+	}
+#endif
+
+#if defined(PLYCPP_HAS_SSSE3)
+	/// Masks gathering bytes between 3 channels of 16 values and 3 vectors of interleaved values
+	struct Interleave1x3Masks
+	{
+		Interleave1x3Masks()
+		{
+			for (int v = 0; v < 3; ++v)
+			{
+				for (int c = 0; c < 3; ++c)
+				{
+					char pack[16];
+					char unpack[16];
+					for (int k = 0; k < 16; ++k)
+					{
+						// k-th byte of the v-th interleaved vector
+						const int packed = 16 * v + k;
+						pack[k] = (packed % 3 == c) ? static_cast<char>(packed / 3) : char(0x80);
+						// Byte of the k-th value of channel c
+						const int value = 3 * k + c;
+						unpack[k] = (value / 16 == v) ? static_cast<char>(value % 16) : char(0x80);
+					}
+					packMasks[v][c] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pack));
+					unpackMasks[v][c] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(unpack));
+				}
+			}
+		}
+
+		__m128i packMasks[3][3];
+		__m128i unpackMasks[3][3];
+	};
+
+	size_t packValues1x3(const unsigned char* const* channels, const size_t count, unsigned char* output)
+	{
+		static const Interleave1x3Masks masks;
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i in[3];
+			for (int c = 0; c < 3; ++c)
+				in[c] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(channels[c] + i));
+			for (int v = 0; v < 3; ++v)
+			{
+				const __m128i out = _mm_or_si128(_mm_or_si128(
+					_mm_shuffle_epi8(in[0], masks.packMasks[v][0]),
+					_mm_shuffle_epi8(in[1], masks.packMasks[v][1])),
+					_mm_shuffle_epi8(in[2], masks.packMasks[v][2]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 3 * i + 16 * v), out);
+			}
+		}
+		return i;
+	}
+
+	size_t unpackValues1x3(const unsigned char* input, const size_t count, unsigned char* const* channels)
+	{
+		static const Interleave1x3Masks masks;
+		size_t i = 0;
+		for (; i + 16 <= count; i += 16)
+		{
+			__m128i in[3];
+			for (int v = 0; v < 3; ++v)
+				in[v] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 3 * i + 16 * v));
+			for (int c = 0; c < 3; ++c)
+			{
+				const __m128i out = _mm_or_si128(_mm_or_si128(
+					_mm_shuffle_epi8(in[0], masks.unpackMasks[0][c]),
+					_mm_shuffle_epi8(in[1], masks.unpackMasks[1][c])),
+					_mm_shuffle_epi8(in[2], masks.unpackMasks[2][c]));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(channels[c] + i), out);
+			}
+		}
+		return i;
+	}
+#endif
+
+	void packValues(const unsigned char* const* channels, const size_t channelsCount, const size_t valueSize, const size_t count, unsigned char* output)
+	{
+		size_t i = 0;
+#if defined(PLYCPP_HAS_SSE2)
+		if (valueSize == 4 && channelsCount == 3)
+			i = packValues4x3(channels, count, output);
+		else if (valueSize == 4 && channelsCount == 4)
+			i = packValues4x4(channels, count, output);
+		else if (valueSize == 1 && channelsCount == 4)
+			i = packValues1x4(channels, count, output);
+#endif
+#if defined(PLYCPP_HAS_SSSE3)
+		if (valueSize == 1 && channelsCount == 3)
+			i = packValues1x3(channels, count, output);
+#endif
+
+		if (valueSize == 1 && channelsCount == 3)
+			packValues<1, 3>(channels, i, count, output);
+		else if (valueSize == 1 && channelsCount == 4)
+			packValues<1, 4>(channels, i, count, output);
+		else if (valueSize == 4 && channelsCount == 3)
+			packValues<4, 3>(channels, i, count, output);
+		else if (valueSize == 4 && channelsCount == 4)
+			packValues<4, 4>(channels, i, count, output);
+		else if (valueSize == 8 && channelsCount == 3)
+			packValues<8, 3>(channels, i, count, output);
+		else if (valueSize == 8 && channelsCount == 4)
+			packValues<8, 4>(channels, i, count, output);
+		else
+		{
+			for (; i < count; ++i)
+			{
+				for (size_t j = 0; j < channelsCount; ++j)
+					std::memcpy(output + (i * channelsCount + j) * valueSize, channels[j] + i * valueSize, valueSize);
+			}
+		}
+	}
+
+	void unpackValues(const unsigned char* input, const size_t channelsCount, const size_t valueSize, const size_t count, unsigned char* const* channels)
+	{
+		size_t i = 0;
+#if defined(PLYCPP_HAS_SSE2)
+		if (valueSize == 4 && channelsCount == 3)
+			i = unpackValues4x3(input, count, channels);
+		else if (valueSize == 4 && channelsCount == 4)
+			i = unpackValues4x4(input, count, channels);
+		else if (valueSize == 8 && channelsCount == 3)
+			i = unpackValues8x3(input, count, channels);
+		else if (valueSize == 8 && channelsCount == 4)
+			i = unpackValues8x4(input, count, channels);
+		else if (valueSize == 1 && channelsCount == 4)
+			i = unpackValues1x4(input, count, channels);
+#endif
+#if defined(PLYCPP_HAS_SSSE3)
+		if (valueSize == 1 && channelsCount == 3)
+			i = unpackValues1x3(input, count, channels);
+#endif
+
+		if (valueSize == 1 && channelsCount == 3)
+			unpackValues<1, 3>(input, i, count, channels);
+		else if (valueSize == 1 && channelsCount == 4)
+			unpackValues<1, 4>(input, i, count, channels);
+		else if (valueSize == 4 && channelsCount == 3)
+			unpackValues<4, 3>(input, i, count, channels);
+		else if (valueSize == 4 && channelsCount == 4)
+			unpackValues<4, 4>(input, i, count, channels);
+		else if (valueSize == 8 && channelsCount == 3)
+			unpackValues<8, 3>(input, i, count, channels);
+		else if (valueSize == 8 && channelsCount == 4)
+			unpackValues<8, 4>(input, i, count, channels);
+		else
+		{
+			for (; i < count; ++i)
+			{
+				for (size_t j = 0; j < channelsCount; ++j)
+					std::memcpy(channels[j] + i * valueSize, input + (i * channelsCount + j) * valueSize, valueSize);
+			}
+		}
+	}
+
+	/// Size of the blocks of records read at once for fixed-stride binary elements, per thread
+	const size_t binaryReadBlockSize = 1 << 20;
+
+	/// Copy one value of StepSize bytes out of each of 'count' consecutive records
+	template<size_t StepSize>
+	void deinterleave(const unsigned char* src, const size_t recordSize, const size_t count, unsigned char* dst)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::memcpy(dst, src, StepSize);
+			src += recordSize;
+			dst += StepSize;
+		}
+	}
+
+	void deinterleave(const unsigned char* src, const size_t recordSize, const size_t count, const size_t stepSize, unsigned char* dst)
+	{
+		switch (stepSize)
+		{
+		case 1:
+			deinterleave<1>(src, recordSize, count, dst);
+			break;
+		case 2:
+			deinterleave<2>(src, recordSize, count, dst);
+			break;
+		case 4:
+			deinterleave<4>(src, recordSize, count, dst);
+			break;
+		case 8:
+			deinterleave<8>(src, recordSize, count, dst);
+			break;
+		default:
+			throw Exception("Should not happen.");
+		}
+	}
+
+	/// Append 'count' items of 'stepSize' bytes to the values of a list property, filled by 'readChunk(items, chunkCount)'.
+	/// Storage grows by bounded chunks, so that a corrupt count makes the read fail instead of allocating its whole size.
+	template<typename ReadChunk>
+	bool appendListItems(PropertyArray& prop, const size_t count, const size_t stepSize, const ReadChunk& readChunk)
+	{
+		const size_t itemsPerChunk = binaryReadBlockSize / stepSize;
+		for (size_t k = 0; k < count; k += itemsPerChunk)
+		{
+			const size_t chunkCount = std::min(itemsPerChunk, count - k);
+			const size_t first = prop.data.size();
+			prop.data.resize(first + chunkCount * stepSize);
+			if (!readChunk(&prop.data[first], chunkCount))
+				return false;
+		}
+		return true;
+	}
+
+	/// Whether each property of an element is stepped over instead of being loaded, in the order of the element
+	typedef std::vector<bool> SkippedProperties;
+
+	bool hasListProperty(const ElementArray& elementArray)
+	{
+		for (const auto& propertyTuple : elementArray.properties)
+		{
+			if (propertyTuple.data->isList)
+				return true;
+		}
+		return false;
+	}
+
+	/// Size of a record of a binary element without list properties
+	size_t getRecordSize(const ElementArray& elementArray)
+	{
+		size_t recordSize = 0;
+		for (const auto& propertyTuple : elementArray.properties)
+			recordSize += propertyTuple.data->stepSize;
+		return recordSize;
+	}
+
+	/// Byte offset of the records of each element of a body starting at 'bodyOffset'.
+	/// Offsets are unknown in ASCII bodies, and after the first binary element with list properties.
+	void getElementOffsets(const PLYData& data, const bool ascii, const size_t bodyOffset, std::vector<size_t>& offsets)
+	{
+		offsets.clear();
+		size_t offset = ascii ? PLYHeader::unknownOffset : bodyOffset;
+		for (const auto& elementArrayTuple : data)
+		{
+			offsets.push_back(offset);
+			const ElementArray& elementArray = *elementArrayTuple.data;
+			if (offset == PLYHeader::unknownOffset || hasListProperty(elementArray))
+				offset = PLYHeader::unknownOffset;
+			else
+				offset += getRecordSize(elementArray) * elementArray.size();
+		}
+	}
+
+	/// Buffered reader of the binary body of a PLY file
+	class BinaryReader
+	{
+	public:
+		BinaryReader(std::istream& fin)
+			: fin(fin),
+			origin(fin.tellg()),
+			buffer(1 << 16)
+		{}
+
+		/// Read 'count' bytes. Returns false if the stream ends before.
+		bool read(void* destination, size_t count)
+		{
+			unsigned char* out = static_cast<unsigned char*>(destination);
+			while (true)
+			{
+				const size_t available = end - position;
+				if (count <= available)
+				{
+					std::memcpy(out, &buffer[position], count);
+					position += count;
+					return true;
+				}
+				std::memcpy(out, &buffer[position], available);
+				position = end;
+				out += available;
+				count -= available;
+
+				// Large reads bypass the buffer
+				if (count >= buffer.size())
+				{
+					fin.read(reinterpret_cast<char*>(out), count);
+					consumed += static_cast<size_t>(fin.gcount());
+					return !fin.fail();
+				}
+				if (!refill())
+					return false;
+			}
+		}
+
+		/// Skip 'count' bytes
+		bool skip(const size_t count)
+		{
+			const size_t available = end - position;
+			if (count <= available)
+			{
+				position += count;
+				return true;
+			}
+			size_t remaining = count - available;
+			position = end;
+			fin.seekg(static_cast<std::streamoff>(remaining), std::ios::cur);
+			if (!fin.fail())
+			{
+				consumed += remaining;
+				return true;
+			}
+
+			// Streams that cannot seek, e.g. pipes, are read through
+			fin.clear();
+			while (remaining > 0)
+			{
+				if (!refill())
+					return false;
+				const size_t stepped = std::min(remaining, end - position);
+				position += stepped;
+				remaining -= stepped;
+			}
+			return true;
+		}
+
+		/// Size of the internal buffer
+		size_t capacity() const
+		{
+			return buffer.size();
+		}
+
+		/// Read 'count' bytes, at most the capacity, without copying them out of the internal buffer.
+		/// Returns null if the stream ends before. The bytes remain valid until the next read.
+		const unsigned char* readInPlace(const size_t count)
+		{
+			assert(count <= buffer.size());
+			const size_t available = end - position;
+			if (count > available)
+			{
+				// Complete the available bytes, moved to the front of the buffer
+				std::memmove(buffer.data(), &buffer[position], available);
+				fin.read(reinterpret_cast<char*>(&buffer[available]), buffer.size() - available);
+				const size_t read = static_cast<size_t>(fin.gcount());
+				consumed += read;
+				if (fin.eof())
+					fin.clear(std::ios::eofbit);
+				position = 0;
+				end = available + read;
+				if (count > end)
+					return nullptr;
+			}
+			const unsigned char* bytes = &buffer[position];
+			position += count;
+			return bytes;
+		}
+
+		/// Position of the next byte to read in the stream
+		std::streamoff tell() const
+		{
+			return origin + static_cast<std::streamoff>(consumed - (end - position));
+		}
+
+		/// True if there is no more data to read
+		bool atEnd()
+		{
+			return position == end && !refill();
+		}
+
+	private:
+		bool refill()
+		{
+			fin.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+			position = 0;
+			end = static_cast<size_t>(fin.gcount());
+			consumed += end;
+			// Reaching the end of the stream is only an error if some data is missing
+			if (fin.eof())
+				fin.clear(std::ios::eofbit);
+			return end > 0;
+		}
+
+		std::istream& fin;
+		const std::streamoff origin;
+		UninitializedBuffer<unsigned char> buffer;
+		size_t position = 0;
+		size_t end = 0;
+		/// Number of bytes read from the stream
+		size_t consumed = 0;
+	};
+
+	/// Let the properties of a binary element without list properties refer to the records in memory,
+	/// and move the reader past them.
+	bool viewFixedStrideBinaryElement(BinaryReader& reader, ElementArray& elementArray, const SkippedProperties& skipped, const MemoryRange& memory)
+	{
+		size_t recordSize = 0;
+		for (const auto& propertyTuple : elementArray.properties)
+			recordSize += propertyTuple.data->stepSize;
+
+		const size_t elementsCount = elementArray.size();
+		const std::streamoff position = reader.tell();
+		if (position < 0 || memory.size < static_cast<size_t>(position)
+			|| (recordSize > 0 && (memory.size - static_cast<size_t>(position)) / recordSize < elementsCount))
+		{
+			return false;
+		}
+
+		const unsigned char* records = memory.begin + position;
+		if (std::find(skipped.begin(), skipped.end(), true) == skipped.end())
+		{
+			elementArray.setInterleavedRecords(memory.owner, records, recordSize);
+		}
+		else
+		{
+			size_t offset = 0;
+			size_t j = 0;
+			for (auto& propertyTuple : elementArray.properties)
+			{
+				auto& prop = propertyTuple.data;
+				if (!skipped[j++])
+					prop->setView(memory.owner, records + offset, recordSize, elementsCount);
+				offset += prop->stepSize;
+			}
+		}
+		return reader.skip(elementsCount * recordSize);
+	}
+
+	/// Read at once the records of a binary element without list properties, and let the properties refer to them
+	bool readInterleavedBinaryElement(BinaryReader& reader, ElementArray& elementArray, const bool swapBytes)
+	{
+		const size_t recordSize = getRecordSize(elementArray);
+		const size_t elementsCount = elementArray.size();
+
+		std::shared_ptr<std::vector<unsigned char> > records(new std::vector<unsigned char>(elementsCount * recordSize));
+		if (!reader.read(records->data(), records->size()))
+			return false;
+
+		if (swapBytes)
+		{
+			// Each field is swapped across all the records at once
+			size_t offset = 0;
+			for (auto& propertyTuple : elementArray.properties)
+			{
+				const size_t stepSize = propertyTuple.data->stepSize;
+				byteSwapStridedValues(records->data() + offset, elementsCount, stepSize, recordSize);
+				offset += stepSize;
+			}
+		}
+
+		elementArray.setInterleavedRecords(records, records->data(), recordSize);
+		return true;
+	}
+
+	/// Storage of the values of a property without lists to be loaded: the storage it was given in an arena, or its own data
+	unsigned char* allocateValues(PropertyArray& prop, const size_t count)
+	{
+		if (prop.isView())
+		{
+			assert(prop.size() == count);
+			return prop.mutableBytes();
+		}
+		prop.data.resize(count * prop.stepSize);
+		return prop.data.data();
+	}
+
+	/// Dispatch 'count' consecutive records, starting with record 'first', into the property arrays
+	void deinterleaveRecords(const unsigned char* records, const size_t recordSize, const size_t first, const size_t count, ElementArray& elementArray, const SkippedProperties& skipped, const bool swapBytes)
+	{
+		size_t offset = 0;
+		size_t j = 0;
+		for (auto& propertyTuple : elementArray.properties)
+		{
+			auto& prop = propertyTuple.data;
+			if (skipped[j++])
+			{
+				offset += prop->stepSize;
+				continue;
+			}
+			assert(first + count <= prop->size());
+			unsigned char* ptData = prop->mutableBytes() + first * prop->stepSize;
+			deinterleave(records + offset, recordSize, count, prop->stepSize, ptData);
+			if (swapBytes)
+				byteSwapValues(ptData, count, prop->stepSize);
+			offset += prop->stepSize;
+		}
+	}
+
+	/// Read a binary element without list properties by blocks of records,
+	/// and dispatch each block into the property arrays, possibly with several threads.
+	bool readFixedStrideBinaryElement(BinaryReader& reader, ElementArray& elementArray, const SkippedProperties& skipped, std::vector<unsigned char>& buffer, WorkerPool& workers, const bool swapBytes)
+	{
+		const size_t threadsCount = workers.size();
+		size_t recordSize = 0;
+		for (const auto& propertyTuple : elementArray.properties)
+			recordSize += propertyTuple.data->stepSize;
+		if (recordSize == 0)
+			return true;
+
+		const size_t elementsCount = elementArray.size();
+		bool skippedElement = true;
+		size_t j = 0;
+		for (auto& propertyTuple : elementArray.properties)
+		{
+			auto& prop = propertyTuple.data;
+			if (skipped[j++])
+				continue;
+			allocateValues(*prop, elementsCount);
+			skippedElement = false;
+		}
+
+		// Records of which nothing is loaded are not even read
+		if (skippedElement)
+			return reader.skip(elementsCount * recordSize);
+
+		// Small elements are dispatched straight from the buffer of the reader
+		if (elementsCount * recordSize <= reader.capacity())
+		{
+			const unsigned char* records = reader.readInPlace(elementsCount * recordSize);
+			if (!records)
+				return false;
+			deinterleaveRecords(records, recordSize, 0, elementsCount, elementArray, skipped, swapBytes);
+			return true;
+		}
+
+		const size_t recordsPerBlock = std::max<size_t>(1, threadsCount * binaryReadBlockSize / recordSize);
+		buffer.resize(std::min(recordsPerBlock, elementsCount) * recordSize);
+
+		for (size_t first = 0; first < elementsCount; first += recordsPerBlock)
+		{
+			const size_t count = std::min(recordsPerBlock, elementsCount - first);
+			if (!reader.read(buffer.data(), count * recordSize))
+				return false;
+
+			if (threadsCount == 1)
+			{
+				deinterleaveRecords(buffer.data(), recordSize, first, count, elementArray, skipped, swapBytes);
+			}
+			else
+			{
+				// Each thread dispatches a contiguous range of records of the block
+				workers.run(threadsCount, [&](const size_t t)
+				{
+					const size_t begin = t * count / threadsCount;
+					const size_t end = (t + 1) * count / threadsCount;
+					deinterleaveRecords(buffer.data() + begin * recordSize, recordSize, first + begin, end - begin, elementArray, skipped, swapBytes);
+				});
+			}
+		}
+		return true;
+	}
+
+	/// Step of a decode plan, resolved once per element from one of its properties (or from several skipped ones)
+	struct DecodeOp
+	{
+		enum Kind
+		{
+			/// Value of the i-th record, stored at 'values' + i * 'stepSize'
+			VALUE,
+			/// List, appended to 'prop'
+			LIST,
+			/// 'skippedCount' consecutive values of 'skippedBytes' bytes in total, stepped over
+			SKIP_VALUES,
+			/// List stepped over
+			SKIP_LIST
+		};
+
+		Kind kind;
+		PropertyArray* prop;
+		unsigned char* values;
+		size_t stepSize;
+		size_t skippedCount;
+		size_t skippedBytes;
+		ASCIIParser parser;
+		/// Decoder of the counts of binary lists, stored on 'countSize' bytes
+		ListCountDecoder countDecoder;
+		size_t countSize;
+		/// For lists parsed with several threads, index among the list properties of the body
+		size_t listIndex;
+	};
+
+	/// Operations reading the properties of a record, in order
+	typedef std::vector<DecodeOp> DecodePlan;
+
+	/// Compile the decode plan of an element, and allocate the storage of its loaded properties.
+	/// List counts are decoded from their binary representation if 'binary' is set.
+	void compileDecodePlan(ElementArray& elementArray, const SkippedProperties& skipped, const bool binary, DecodePlan& plan)
+	{
+		const size_t elementsCount = elementArray.size();
+		plan.clear();
+		size_t j = 0;
+		for (auto& propertyTuple : elementArray.properties)
+		{
+			PropertyArray* prop = propertyTuple.data.get();
+			const bool loaded = !skipped[j++];
+
+			// Consecutive values stepped over are merged
+			if (!loaded && !prop->isList && !plan.empty() && plan.back().kind == DecodeOp::SKIP_VALUES)
+			{
+				++plan.back().skippedCount;
+				plan.back().skippedBytes += prop->stepSize;
+				continue;
+			}
+
+			DecodeOp op;
+			op.prop = prop;
+			op.values = nullptr;
+			op.stepSize = prop->stepSize;
+			op.skippedCount = 1;
+			op.skippedBytes = prop->stepSize;
+			op.parser = getASCIIParser(prop->type);
+			op.countDecoder = (binary && prop->isList) ? getListCountDecoder(prop->listCountType) : nullptr;
+			op.countSize = (binary && prop->isList) ? dataTypeToStepSize(prop->listCountType) : 0;
+			op.listIndex = 0;
+			if (!loaded)
+			{
+				op.kind = prop->isList ? DecodeOp::SKIP_LIST : DecodeOp::SKIP_VALUES;
+			}
+			else if (prop->isList)
+			{
+				op.kind = DecodeOp::LIST;
+				// Storage of typical triangle lists, extended when needed
+				prop->data.clear();
+				prop->data.reserve(3 * elementsCount * prop->stepSize);
+				prop->offsets.resize(elementsCount + 1);
+				prop->offsets[0] = 0;
+			}
+			else
+			{
+				op.kind = DecodeOp::VALUE;
+				op.values = allocateValues(*prop, elementsCount);
+			}
+			plan.push_back(op);
+		}
+	}
+
+	/// Read the records of an element from an ASCII body
+	void readASCIIElement(ASCIITokenizer& tokenizer, ElementArray& elementArray, const SkippedProperties& skipped)
+	{
+		DecodePlan plan;
+		compileDecodePlan(elementArray, skipped, false, plan);
+
+		// Iterate over elements
+		const size_t elementsCount = elementArray.size();
+		for (size_t i = 0; i < elementsCount; ++i)
+		{
+			// Walk the plan for each element
+			for (const DecodeOp& op : plan)
+			{
+				switch (op.kind)
+				{
+				case DecodeOp::VALUE:
+					if (!tokenizer.read(op.parser, op.values + i * op.stepSize))
+						throw Exception("Issue while parsing ascii data");
+					break;
+				case DecodeOp::LIST:
+				{
+					// Read count
+					size_t count;
+					if (!tokenizer.read(&parseASCIIListCount, reinterpret_cast<unsigned char*>(&count)))
+						throw Exception("Issue while parsing ascii data");
+
+					// Read items
+					PropertyArray* prop = op.prop;
+					const bool success = appendListItems(*prop, count, op.stepSize, [&](unsigned char* items, const size_t chunkCount) {
+						for (size_t k = 0; k < chunkCount; ++k)
+						{
+							if (!tokenizer.read(op.parser, items + k * op.stepSize))
+								return false;
+						}
+						return true;
+					});
+					if (!success)
+						throw Exception("Issue while parsing ascii data");
+					prop->offsets[i + 1] = prop->offsets[i] + count;
+					break;
+				}
+				case DecodeOp::SKIP_VALUES:
+					for (size_t k = 0; k < op.skippedCount; ++k)
+					{
+						if (!tokenizer.skip())
+							throw Exception("Issue while parsing ascii data");
+					}
+					break;
+				case DecodeOp::SKIP_LIST:
+				{
+					size_t count;
+					if (!tokenizer.read(&parseASCIIListCount, reinterpret_cast<unsigned char*>(&count)))
+						throw Exception("Issue while parsing ascii data");
+					for (size_t k = 0; k < count; ++k)
+					{
+						if (!tokenizer.skip())
+							throw Exception("Issue while parsing ascii data");
+					}
+					break;
+				}
+				}
+			}
+		}
+	}
+
+	/// Read the body of an ASCII PLY file
+	void readASCIIDataContent(std::istream& fin, PLYData& data, const std::vector<SkippedProperties>& skipped)
+	{
+		ASCIITokenizer tokenizer(fin);
+
+		//// Iterate over the elements array to read
+		auto elementArrayTuple = data.begin();
+		for (size_t e = 0; e < skipped.size(); ++e, ++elementArrayTuple)
+			readASCIIElement(tokenizer, *elementArrayTuple->data, skipped[e]);
+	}
+
+	/// Lists of a property parsed from a chunk of lines, before being appended to the property
+	struct ASCIIListChunk
+	{
+		size_t firstRecord;
+		std::vector<size_t> counts;
+		std::vector<unsigned char> values;
+	};
+
+	/// Range of records of an element, in the sequence of lines of an ASCII body
+	struct ASCIIElementLines
+	{
+		size_t firstLine;
+		size_t count;
+		DecodePlan plan;
+	};
+
+	bool isBlankLine(const char* it, const char* const end)
+	{
+		for (; it != end; ++it)
+		{
+			if (*it != ' ' && *it != '\t' && *it != '\r' && *it != '\v' && *it != '\f')
+				return false;
+		}
+		return true;
+	}
+
+	/// Get the next token of a line
+	bool nextLineToken(const char*& it, const char* const end, const char*& tokenBegin, const char*& tokenEnd)
+	{
+		while (it != end && (*it == ' ' || *it == '\t' || *it == '\r' || *it == '\v' || *it == '\f'))
+			++it;
+		if (it == end)
+			return false;
+		tokenBegin = it;
+		while (it != end && *it != ' ' && *it != '\t' && *it != '\r' && *it != '\v' && *it != '\f')
+			++it;
+		tokenEnd = it;
+		return true;
+	}
+
+	/// Parse a line holding the i-th record of an element. List items are stored in 'lists'.
+	void parseASCIILine(const char* it, const char* const end, const ASCIIElementLines& element, const size_t i, std::vector<ASCIIListChunk>& lists)
+	{
+		const char* tokenBegin;
+		const char* tokenEnd;
+		for (const DecodeOp& op : element.plan)
+		{
+			switch (op.kind)
+			{
+			case DecodeOp::VALUE:
+				if (!nextLineToken(it, end, tokenBegin, tokenEnd) || !op.parser(tokenBegin, tokenEnd, op.values + i * op.stepSize))
+					throw Exception("Issue while parsing ascii data");
+				break;
+			case DecodeOp::LIST:
+			{
+				size_t count;
+				if (!nextLineToken(it, end, tokenBegin, tokenEnd) || !parseASCIIListCount(tokenBegin, tokenEnd, reinterpret_cast<unsigned char*>(&count)))
+					throw Exception("Issue while parsing ascii data");
+
+				// Each item takes at least a character and a separator on the rest of the line
+				if (count > static_cast<size_t>(end - it + 1) / 2)
+					throw Exception("Issue while parsing ascii data");
+
+				ASCIIListChunk& chunk = lists[op.listIndex];
+				if (chunk.counts.empty())
+					chunk.firstRecord = i;
+				chunk.counts.push_back(count);
+				const size_t first = chunk.values.size();
+				chunk.values.resize(first + count * op.stepSize);
+				for (size_t k = 0; k < count; ++k)
+				{
+					if (!nextLineToken(it, end, tokenBegin, tokenEnd) || !op.parser(tokenBegin, tokenEnd, &chunk.values[first + k * op.stepSize]))
+						throw Exception("Issue while parsing ascii data");
+				}
+				break;
+			}
+			case DecodeOp::SKIP_VALUES:
+			case DecodeOp::SKIP_LIST:
+			{
+				// Step over the values without parsing them
+				size_t count = op.skippedCount;
+				if (op.kind == DecodeOp::SKIP_LIST && (!nextLineToken(it, end, tokenBegin, tokenEnd) || !parseASCIIListCount(tokenBegin, tokenEnd, reinterpret_cast<unsigned char*>(&count))))
+					throw Exception("Issue while parsing ascii data");
+				for (size_t k = 0; k < count; ++k)
+				{
+					if (!nextLineToken(it, end, tokenBegin, tokenEnd))
+						throw Exception("Issue while parsing ascii data");
+				}
+				break;
+			}
+			}
+		}
+		if (nextLineToken(it, end, tokenBegin, tokenEnd))
+			throw Exception("Unexpected value in ascii data. Parsing with several threads requires one element per line.");
+	}
+
+	/// Read the body of an ASCII PLY file with several threads.
+	/// The body is read by large windows split into chunks of lines; each thread first counts
+	/// the lines of its chunk, then parses them directly into their place in the property arrays.
+	void readASCIIDataContentParallel(std::istream& fin, PLYData& data, const std::vector<SkippedProperties>& skipped, WorkerPool& workers)
+	{
+		const size_t threadsCount = workers.size();
+		// Layout of the body to read: one non blank line per record
+		std::vector<ASCIIElementLines> elements;
+		std::vector<PropertyArray*> listProperties;
+		size_t linesCount = 0;
+		auto elementArrayTuple = data.begin();
+		for (size_t e = 0; e < skipped.size(); ++e, ++elementArrayTuple)
+		{
+			auto& elementArray = elementArrayTuple->data;
+			ASCIIElementLines element;
+			element.firstLine = linesCount;
+			element.count = elementArray->size();
+			compileDecodePlan(*elementArray, skipped[e], false, element.plan);
+			for (DecodeOp& op : element.plan)
+			{
+				// Lists are appended once each window is parsed
+				if (op.kind == DecodeOp::LIST)
+				{
+					op.listIndex = listProperties.size();
+					listProperties.push_back(op.prop);
+				}
+			}
+			// Elements without properties do not appear in the body
+			if (element.plan.empty())
+				continue;
+			linesCount += element.count;
+			elements.push_back(element);
+		}
+
+		size_t windowSize = threadsCount * (size_t(8) << 20);
+		std::vector<char> window;
+		size_t carried = 0;
+		size_t parsedLines = 0;
+		bool endOfStream = false;
+		while (parsedLines < linesCount && !endOfStream)
+		{
+			// Complete the window, keeping room for a terminating null character
+			window.resize(carried + windowSize + 1);
+			fin.read(window.data() + carried, windowSize);
+			const size_t size = carried + static_cast<size_t>(fin.gcount());
+			if (fin.eof())
+			{
+				endOfStream = true;
+				fin.clear(std::ios::eofbit);
+			}
+			window[size] = '\0';
+
+			// Only process complete lines, unless the end of the body is reached
+			size_t usable = size;
+			if (!endOfStream)
+			{
+				while (usable > 0 && window[usable - 1] != '\n')
+					--usable;
+				if (usable == 0)
+				{
+					// A single line larger than the window
+					carried = size;
+					windowSize *= 2;
+					continue;
+				}
+			}
+
+			// Split the window in chunks of complete lines
+			std::vector<size_t> boundaries(threadsCount + 1, usable);
+			boundaries[0] = 0;
+			for (size_t t = 1; t < threadsCount; ++t)
+			{
+				size_t boundary = std::max(boundaries[t - 1], t * usable / threadsCount);
+				while (boundary > boundaries[t - 1] && boundary < usable && window[boundary - 1] != '\n')
+					++boundary;
+				boundaries[t] = boundary;
+			}
+
+			// Count the records of each chunk
+			std::vector<size_t> chunkLines(threadsCount, 0);
+			workers.run(threadsCount, [&](const size_t t)
+			{
+				const char* it = window.data() + boundaries[t];
+				const char* const end = window.data() + boundaries[t + 1];
+				while (it != end)
+				{
+					const char* lineEnd = static_cast<const char*>(std::memchr(it, '\n', end - it));
+					if (!lineEnd)
+						lineEnd = end;
+					if (!isBlankLine(it, lineEnd))
+						++chunkLines[t];
+					it = (lineEnd == end) ? end : lineEnd + 1;
+				}
+			});
+
+			// Parse each chunk from its first record
+			std::vector<size_t> firstLines(threadsCount);
+			for (size_t t = 0; t < threadsCount; ++t)
+			{
+				firstLines[t] = parsedLines;
+				parsedLines += chunkLines[t];
+			}
+			std::vector<std::vector<ASCIIListChunk> > chunkLists(threadsCount, std::vector<ASCIIListChunk>(listProperties.size()));
+			workers.run(threadsCount, [&](const size_t t)
+			{
+				size_t line = firstLines[t];
+				size_t e = 0;
+				const char* it = window.data() + boundaries[t];
+				const char* const end = window.data() + boundaries[t + 1];
+				while (it != end && line < linesCount)
+				{
+					const char* lineEnd = static_cast<const char*>(std::memchr(it, '\n', end - it));
+					if (!lineEnd)
+						lineEnd = end;
+					if (!isBlankLine(it, lineEnd))
+					{
+						while (line >= elements[e].firstLine + elements[e].count)
+							++e;
+						parseASCIILine(it, lineEnd, elements[e], line - elements[e].firstLine, chunkLists[t]);
+						++line;
+					}
+					it = (lineEnd == end) ? end : lineEnd + 1;
+				}
+			});
+
+			// Append the lists of each chunk, in order
+			for (size_t t = 0; t < threadsCount; ++t)
+			{
+				for (size_t l = 0; l < listProperties.size(); ++l)
+				{
+					PropertyArray* prop = listProperties[l];
+					const ASCIIListChunk& chunk = chunkLists[t][l];
+					for (size_t k = 0; k < chunk.counts.size(); ++k)
+						prop->offsets[chunk.firstRecord + k + 1] = prop->offsets[chunk.firstRecord + k] + chunk.counts[k];
+					prop->data.insert(prop->data.end(), chunk.values.begin(), chunk.values.end());
+				}
+			}
+
+			// Keep the incomplete last line for the next window
+			carried = size - usable;
+			std::memmove(window.data(), window.data() + usable, carried);
+		}
+
+		if (parsedLines < linesCount)
+			throw Exception("Issue while parsing ascii data");
+	}
+
+	/// Read a binary element with list properties, record by record
+	bool readListBinaryElement(BinaryReader& reader, ElementArray& elementArray, const SkippedProperties& skipped, const bool swapBytes)
+	{
+		DecodePlan plan;
+		compileDecodePlan(elementArray, skipped, true, plan);
+
+		// Iterate over elements
+		const size_t elementsCount = elementArray.size();
+		for (size_t i = 0; i < elementsCount; ++i)
+		{
+			// Walk the plan for each element
+			for (const DecodeOp& op : plan)
+			{
+				switch (op.kind)
+				{
+				case DecodeOp::VALUE:
+					if (!reader.read(op.values + i * op.stepSize, op.stepSize))
+						return false;
+					break;
+				case DecodeOp::SKIP_VALUES:
+					if (!reader.skip(op.skippedBytes))
+						return false;
+					break;
+				case DecodeOp::LIST:
+				case DecodeOp::SKIP_LIST:
+				{
+					// Read count
+					unsigned char countData[sizeof(uint32_t)];
+					if (!reader.read(countData, op.countSize))
+						return false;
+					if (swapBytes)
+						byteSwapValues(countData, 1, op.countSize);
+					size_t count;
+					if (!op.countDecoder(countData, count))
+						throw Exception("Invalid list size");
+
+					if (op.kind == DecodeOp::SKIP_LIST)
+					{
+						if (!reader.skip(count * op.stepSize))
+							return false;
+						break;
+					}
+
+					// Read items
+					PropertyArray* prop = op.prop;
+					const bool success = appendListItems(*prop, count, op.stepSize, [&](unsigned char* items, const size_t chunkCount) {
+						return reader.read(items, chunkCount * op.stepSize);
+					});
+					if (!success)
+						return false;
+					prop->offsets[i + 1] = prop->offsets[i] + count;
+					break;
+				}
+				}
+			}
+		}
+
+		if (swapBytes)
+		{
+			for (const DecodeOp& op : plan)
+			{
+				if (op.kind == DecodeOp::VALUE)
+					byteSwapValues(op.values, elementsCount, op.stepSize);
+				else if (op.kind == DecodeOp::LIST)
+					byteSwapValues(op.prop->data.data(), op.prop->data.size() / op.stepSize, op.stepSize);
+			}
+		}
+		return true;
+	}
+
+	/// Read the body of a binary PLY file, reversing the bytes of each value if 'swapBytes' is set.
+	/// If 'memory' holds the whole file, elements without lists are not copied but refer to it.
+	void readBinaryDataContent(std::istream& fin, PLYData& data, const std::vector<SkippedProperties>& skipped, const MemoryRange* memory, WorkerPool& workers, const bool interleaved, const bool swapBytes)
+	{
+		BinaryReader reader(fin);
+		std::vector<unsigned char> buffer;
+
+		//// Iterate over the elements array to read
+		auto elementArrayTuple = data.begin();
+		for (size_t e = 0; e < skipped.size(); ++e, ++elementArrayTuple)
+		{
+			auto& elementArray = elementArrayTuple->data;
+
+			bool success;
+			if (hasListProperty(*elementArray))
+				success = readListBinaryElement(reader, *elementArray, skipped[e], swapBytes);
+			else if (memory)
+				success = viewFixedStrideBinaryElement(reader, *elementArray, skipped[e], *memory);
+			else if (interleaved && std::find(skipped[e].begin(), skipped[e].end(), true) == skipped[e].end())
+				success = readInterleavedBinaryElement(reader, *elementArray, swapBytes);
+			else
+				success = readFixedStrideBinaryElement(reader, *elementArray, skipped[e], buffer, workers, swapBytes);
+
+			if (!success)
+				throw Exception("Issue while parsing binary data");
+		}
+
+		// Ensure we reached the end of file, unless the last elements are not read
+		if (elementArrayTuple == data.end() && !reader.atEnd())
+		{
+			throw Exception("End of file not reached at the end of parsing.");
+		}
+	}
+
+	void myGetline(std::istream& fin, std::string& line)
+	{
+		std::getline(fin, line);
+		// Files created with Windows have a carriage return
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+	}
+
+	/// Parse the header of a PLY file, and allocate the elements and properties it describes
+	void readHeader(std::istream& fin, PLYData& data, std::string& format)
+	{
+		data.clear();
+		std::string version;
+
+		std::string line;
+		myGetline(fin, line);
+
+		std::shared_ptr<ElementArray> currentElement = nullptr;
+
+		if (line != "ply")
+		{
+			throw Exception("Missing magic number ""ply""");
+		}
+
+		std::vector<std::string> lineContent;
+		while (line != "end_header")
+		{
+			myGetline(fin, line);
+			if (fin.fail())
+				throw Exception("Header parsing exception");
+
+			splitString(line, lineContent);
+
+			if (lineContent.size() == 3 && lineContent[0] == "format")
+			{
+				format = lineContent[1];
+				version = lineContent[2];
+			}
+			if (lineContent.size() == 3 && lineContent[0] == "element")
+			{
+				// New element
+				const std::string& name = lineContent[1];
+				const size_t count = strtol_except(lineContent[2]);
+
+				currentElement = std::make_shared<ElementArray>(count);
+
+				data.push_back(name, currentElement);
+			}
+			else if (lineContent.size() == 3 && lineContent[0] == "property")
+			{
+				if (!currentElement)
+					throw Exception("Header issue!");
+
+				// New property
+				const std::type_index dataType = parseDataType(lineContent[1]);
+				const std::string& name = lineContent[2];
+
+				// Storage is allocated when reading the body
+				std::shared_ptr<PropertyArray> newProperty = std::make_shared<PropertyArray>(dataType, 0);
+				currentElement->properties.push_back(name, newProperty);
+			}
+			else if (lineContent.size() == 5 && lineContent[0] == "property" && lineContent[1] == "list")
+			{
+				if (!currentElement)
+					throw Exception("Header issue!");
+
+				const std::type_index indexCountType = parseDataType(lineContent[2]);
+				const std::type_index dataType = parseDataType(lineContent[3]);
+				const std::string& name = lineContent[4];
+
+				// Ensure the counting type is an integral one
+				getListCountDecoder(indexCountType);
+
+				std::shared_ptr<PropertyArray> newProperty = std::make_shared<PropertyArray>(dataType, 0, true);
+				newProperty->listCountType = indexCountType;
+				currentElement->properties.push_back(name, newProperty);
+			}
+
+		}
+
+		if (fin.fail())
+		{
+			throw Exception("Issue while parsing header");
+		}
+	}
+
+	/// Number of threads to use for a requested count, 0 standing for all the hardware threads
+	size_t getThreadsCount(const unsigned int threadsCount)
+	{
+		return threadsCount > 0 ? threadsCount : std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	/// Number of threads requested by the options
+	size_t getThreadsCount(const LoadOptions& options)
+	{
+		return getThreadsCount(options.threadsCount);
+	}
+
+	/// Whether the values of a binary format have to be byte-swapped on this architecture
+	bool needsByteSwap(const std::string& format)
+	{
+		if (format != "binary_little_endian" && format != "binary_big_endian")
+			throw Exception("Unknown binary format");
+		return (format == "binary_big_endian") != isBigEndianArchitecture();
+	}
+
+	/// Whether a name is selected by a list of names, empty lists selecting every name
+	bool isSelected(const std::vector<std::string>& selection, const std::string& name)
+	{
+		return selection.empty() || std::find(selection.begin(), selection.end(), name) != selection.end();
+	}
+
+	/// Find the properties of each element that are not loaded according to the options.
+	/// Elements following the last selected element are not read at all, and are not part of 'skipped'.
+	/// Check that the elements and properties named by the options exist, so that a typo does not look like an empty file
+	void checkSelection(const PLYData& data, const LoadOptions& options)
+	{
+		for (const std::string& name : options.elements)
+		{
+			if (!data.has_key(name))
+				throw Exception("Unknown element " + name + " in LoadOptions::elements");
+		}
+		for (const std::string& name : options.properties)
+		{
+			bool found = false;
+			for (const auto& elementArrayTuple : data)
+				found = found || (isSelected(options.elements, elementArrayTuple.key) && elementArrayTuple.data->properties.has_key(name));
+			if (!found)
+				throw Exception("Unknown property " + name + " in the elements selected by LoadOptions");
+		}
+	}
+
+	void selectProperties(const PLYData& data, const LoadOptions& options, std::vector<SkippedProperties>& skipped)
+	{
+		checkSelection(data, options);
+		skipped.clear();
+		size_t elementsToRead = 0;
+		for (const auto& elementArrayTuple : data)
+		{
+			const bool selectedElement = isSelected(options.elements, elementArrayTuple.key);
+			SkippedProperties elementSkipped;
+			for (const auto& propertyTuple : elementArrayTuple.data->properties)
+				elementSkipped.push_back(!selectedElement || !isSelected(options.properties, propertyTuple.key));
+			skipped.push_back(elementSkipped);
+			if (selectedElement)
+				elementsToRead = skipped.size();
+		}
+		skipped.resize(elementsToRead);
+	}
+
+	/// Get the elements and properties of 'data' that are selected by the options, sharing their property arrays
+	void getSelectedData(const PLYData& data, const LoadOptions& options, PLYData& selectedData)
+	{
+		selectedData.clear();
+		for (const auto& elementArrayTuple : data)
+		{
+			if (!isSelected(options.elements, elementArrayTuple.key))
+				continue;
+			std::shared_ptr<ElementArray> element(new ElementArray(elementArrayTuple.data->size()));
+			for (const auto& propertyTuple : elementArrayTuple.data->properties)
+			{
+				if (isSelected(options.properties, propertyTuple.key))
+					element->properties.push_back(propertyTuple.key, propertyTuple.data);
+			}
+			selectedData.push_back(elementArrayTuple.key, element);
+		}
+	}
+
+	/// Let the loaded properties without lists share a single uninitialized allocation, except those which will refer to the file.
+	/// 'memoryMapped' tells whether binary elements without lists will refer to a mapped file.
+	void allocateArena(PLYData& data, const std::vector<SkippedProperties>& skipped, const bool ascii, const bool memoryMapped, const bool interleaved, const std::function<std::shared_ptr<unsigned char>(size_t)>& allocator)
+	{
+		// Slices are aligned for any type of value
+		const size_t alignment = 16;
+
+		struct Slice
+		{
+			PropertyArray* prop;
+			size_t offset;
+			size_t size;
+		};
+		std::vector<Slice> slices;
+		size_t arenaSize = 0;
+		auto elementArrayTuple = data.begin();
+		for (size_t e = 0; e < skipped.size(); ++e, ++elementArrayTuple)
+		{
+			ElementArray& elementArray = *elementArrayTuple->data;
+			const bool allLoaded = std::find(skipped[e].begin(), skipped[e].end(), true) == skipped[e].end();
+			if (!ascii && !hasListProperty(elementArray) && (memoryMapped || (interleaved && allLoaded)))
+				continue;
+
+			size_t j = 0;
+			for (auto& propertyTuple : elementArray.properties)
+			{
+				PropertyArray* prop = propertyTuple.data.get();
+				if (skipped[e][j++] || prop->isList)
+					continue;
+				Slice slice = { prop, arenaSize, elementArray.size() };
+				slices.push_back(slice);
+				arenaSize += (slice.size * prop->stepSize + alignment - 1) / alignment * alignment;
+			}
+		}
+		if (arenaSize == 0)
+			return;
+
+		std::shared_ptr<unsigned char> arena = allocator ? allocator(arenaSize) : std::shared_ptr<unsigned char>(new unsigned char[arenaSize], std::default_delete<unsigned char[]>());
+		if (!arena)
+			throw Exception("Unable to allocate the arena");
+		for (const Slice& slice : slices)
+			slice.prop->setStorage(arena, arena.get() + slice.offset, slice.size);
+	}
+
+	/// Read the body of a PLY file, following its header
+	void readBody(std::istream& fin, const std::string& format, PLYData& data, const LoadOptions& options, const MemoryRange* memory)
+	{
+		WorkerPool workers(getThreadsCount(options));
+		std::vector<SkippedProperties> skipped;
+		selectProperties(data, options, skipped);
+
+		const bool ascii = (format == "ascii");
+		if (options.arena)
+			allocateArena(data, skipped, ascii, !ascii && memory && !needsByteSwap(format), options.interleaved, options.arenaAllocator);
+
+		if (ascii)
+		{
+			if (workers.size() > 1)
+				readASCIIDataContentParallel(fin, data, skipped, workers);
+			else
+				readASCIIDataContent(fin, data, skipped);
+
+			if (fin.fail())
+			{
+				throw Exception("Issue while parsing ascii data");
+			}
+		}
+		else
+		{
+			// Values of a file with a different endianness are converted, hence cannot refer to the file
+			const bool swapBytes = needsByteSwap(format);
+			readBinaryDataContent(fin, data, skipped, swapBytes ? nullptr : memory, workers, options.interleaved, swapBytes);
+		}
+
+		if (!options.elements.empty() || !options.properties.empty())
+		{
+			PLYData selectedData;
+			getSelectedData(data, options, selectedData);
+			data = selectedData;
+		}
+	}
+
+	void load(const std::string& filename, PLYData& data)
+	{
+		load(filename, data, LoadOptions());
+	}
+
+	/// Load PLY data held in memory. Binary properties refer to it with LoadOptions::memoryMapped.
+	void loadFromMemory(const MemoryRange& memory, PLYData& data, const LoadOptions& options)
+	{
+		data.clear();
+		std::string format;
+
+		MemoryStreamBuffer buffer(memory.begin, memory.size);
+		std::istream fin(&buffer);
+		if (memory.size > 0 && detectCompression(memory.begin[0]) != Compression::UNCOMPRESSED)
+			return load(fin, data, options);
+
+		readHeader(fin, data, format);
+		readBody(fin, format, data, options, options.memoryMapped ? &memory : nullptr);
+	}
+
+	void load(const std::string& filename, PLYData& data, const LoadOptions& options)
+	{
+		if (options.memoryMapped)
+		{
+			std::shared_ptr<MappedFile> mappedFile(new MappedFile(filename));
+			MemoryRange memory;
+			memory.owner = mappedFile;
+			memory.begin = mappedFile->data();
+			memory.size = mappedFile->size();
+			loadFromMemory(memory, data, options);
+		}
+		else
+		{
+#ifdef __linux__
+			if (options.directIO)
+			{
+				DirectInputStreamBuffer buffer(filename);
+				std::istream fin(&buffer);
+				return load(fin, data, options);
+			}
+#endif
+			std::ifstream fin(filename, std::ios::binary);
+			//fin.sync_with_stdio(false);
+
+			if (!fin.is_open())
+				throw Exception(std::string("Unable to open ") + filename);
+
+			load(fin, data, options);
+		}
+	}
+
+	void load(const void* buffer, const size_t size, PLYData& data)
+	{
+		load(buffer, size, data, LoadOptions());
+	}
+
+	void load(const void* buffer, const size_t size, PLYData& data, const LoadOptions& options)
+	{
+		// The caller keeps the buffer alive
+		MemoryRange memory;
+		memory.begin = static_cast<const unsigned char*>(buffer);
+		memory.size = size;
+		loadFromMemory(memory, data, options);
+	}
+
+	void load(std::istream& fin, PLYData& data)
+	{
+		load(fin, data, LoadOptions());
+	}
+
+	void load(std::istream& fin, PLYData& data, const LoadOptions& options)
+	{
+		data.clear();
+		std::string format;
+
+		const Compression compression = detectCompression(fin.peek());
+		if (compression != Compression::UNCOMPRESSED)
+		{
+			std::unique_ptr<DecompressingStreamBuffer> buffer = makeDecompressingStreamBuffer(compression, *fin.rdbuf());
+			std::istream decompressed(buffer.get());
+			load(decompressed, data, options);
+			return;
+		}
+
+		readHeader(fin, data, format);
+		readBody(fin, format, data, options, nullptr);
+	}
+
+
+	void readHeader(std::istream& fin, PLYHeader& header)
+	{
+		std::string format;
+		readHeader(fin, header.elements, format);
+		if (format == "ascii")
+			header.format = FileFormat::ASCII;
+		else if (format == "binary_little_endian")
+			header.format = FileFormat::BINARY_LITTLE_ENDIAN;
+		else if (format == "binary_big_endian")
+			header.format = FileFormat::BINARY_BIG_ENDIAN;
+		else
+			throw Exception("Unknown format " + format);
+
+		header.bodyOffset = static_cast<size_t>(fin.tellg());
+		getElementOffsets(header.elements, header.format == FileFormat::ASCII, header.bodyOffset, header.elementOffsets);
+	}
+
+	void readHeader(const std::string& filename, PLYHeader& header)
+	{
+		std::ifstream fin(filename, std::ios::binary);
+		if (!fin.is_open())
+			throw Exception(std::string("Unable to open ") + filename);
+
+		const Compression compression = detectCompression(fin.peek());
+		if (compression != Compression::UNCOMPRESSED)
+		{
+			std::unique_ptr<DecompressingStreamBuffer> buffer = makeDecompressingStreamBuffer(compression, *fin.rdbuf());
+			std::istream decompressed(buffer.get());
+			readHeader(decompressed, header);
+		}
+		else
+		{
+			readHeader(fin, header);
+		}
+	}
+
+	/// Read a range of records of a binary element without lists, whose header has just been read from 'fin'
+	void readBinaryRange(std::istream& fin, const std::string& format, const std::string& elementName, const size_t first, const size_t count,
+		PLYData& data, const LoadOptions& options, const MemoryRange* memory)
+	{
+		if (format == "ascii")
+			throw Exception("Ranges of records can only be read from binary files");
+		const bool swapBytes = needsByteSwap(format);
+
+		std::vector<size_t> offsets;
+		getElementOffsets(data, false, static_cast<size_t>(fin.tellg()), offsets);
+
+		auto elementArrayTuple = data.begin();
+		size_t e = 0;
+		while (elementArrayTuple != data.end() && elementArrayTuple->key != elementName)
+		{
+			++elementArrayTuple;
+			++e;
+		}
+		if (elementArrayTuple == data.end())
+			throw Exception("Unknown element " + elementName);
+
+		const ElementArray& elementArray = *elementArrayTuple->data;
+		if (offsets[e] == PLYHeader::unknownOffset || hasListProperty(elementArray))
+			throw Exception("Ranges of records can only be read from elements without lists, following elements without lists");
+		if (first > elementArray.size() || count > elementArray.size() - first)
+			throw Exception("Range of records out of " + elementName);
+		LoadOptions selection;
+		selection.elements.assign(1, elementName);
+		selection.properties = options.properties;
+		checkSelection(data, selection);
+
+		// Records of the range, with the properties of the element
+		std::shared_ptr<ElementArray> range(new ElementArray(count));
+		SkippedProperties skipped;
+		for (const auto& propertyTuple : elementArray.properties)
+		{
+			range->properties.push_back(propertyTuple.key, propertyTuple.data);
+			skipped.push_back(!isSelected(options.properties, propertyTuple.key));
+		}
+
+		fin.seekg(static_cast<std::streamoff>(offsets[e] + first * getRecordSize(elementArray)));
+		BinaryReader reader(fin);
+		std::vector<unsigned char> buffer;
+		bool success;
+		if (memory && !swapBytes)
+			success = viewFixedStrideBinaryElement(reader, *range, skipped, *memory);
+		else
+		{
+			WorkerPool workers(getThreadsCount(options));
+			success = readFixedStrideBinaryElement(reader, *range, skipped, buffer, workers, swapBytes);
+		}
+		if (!success)
+			throw Exception("Issue while parsing binary data");
+
+		// Keep only the range of the element
+		data.clear();
+		data.push_back(elementName, range);
+		PLYData selectedData;
+		getSelectedData(data, selection, selectedData);
+		data = selectedData;
+	}
+
+	void loadRange(const std::string& filename, const std::string& elementName, const size_t first, const size_t count, PLYData& data)
+	{
+		loadRange(filename, elementName, first, count, data, LoadOptions());
+	}
+
+	void loadRange(const std::string& filename, const std::string& elementName, const size_t first, const size_t count, PLYData& data, const LoadOptions& options)
+	{
+		data.clear();
+		std::string format;
+
+		if (options.memoryMapped)
+		{
+			std::shared_ptr<MappedFile> mappedFile(new MappedFile(filename));
+			MemoryRange memory;
+			memory.owner = mappedFile;
+			memory.begin = mappedFile->data();
+			memory.size = mappedFile->size();
+
+			MemoryStreamBuffer buffer(memory.begin, memory.size);
+			std::istream fin(&buffer);
+			checkUncompressed(fin.peek(), "loadRange");
+			readHeader(fin, data, format);
+			readBinaryRange(fin, format, elementName, first, count, data, options, &memory);
+		}
+		else
+		{
+			std::ifstream fin(filename, std::ios::binary);
+
+			if (!fin.is_open())
+				throw Exception(std::string("Unable to open ") + filename);
+
+			checkUncompressed(fin.peek(), "loadRange");
+			readHeader(fin, data, format);
+			readBinaryRange(fin, format, elementName, first, count, data, options, nullptr);
+		}
+	}
+
+	/// Threads and queues of an AsyncLoader
+	class AsyncLoaderState
+	{
+	public:
+		AsyncLoaderState(const AsyncLoadOptions& options)
+			: options(options)
+		{
+			reader = std::thread([this]() { readFiles(); });
+			const size_t decodersCount = getThreadsCount(options.threadsCount);
+			for (size_t i = 0; i < decodersCount; ++i)
+				decoders.push_back(std::thread([this]() { decodeFiles(); }));
+		}
+
+		~AsyncLoaderState()
+		{
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				stopping = true;
+			}
+			changed.notify_all();
+			reader.join();
+			for (std::thread& decoder : decoders)
+				decoder.join();
+		}
+
+		std::future<PLYData> load(const std::string& filename)
+		{
+			Job job;
+			job.filename = filename;
+			std::future<PLYData> result = job.promise.get_future();
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				toRead.push_back(std::move(job));
+			}
+			changed.notify_all();
+			return result;
+		}
+
+	private:
+		struct Job
+		{
+			std::string filename;
+			std::promise<PLYData> promise;
+			std::shared_ptr<UninitializedBuffer<unsigned char> > content;
+		};
+
+		/// Read the requested files in memory, within the limits of the prefetch
+		void readFiles()
+		{
+			while (true)
+			{
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [this]() { return !toRead.empty() || stopping; });
+					if (toRead.empty())
+						break;
+					job = std::move(toRead.front());
+					toRead.pop_front();
+				}
+
+				try
+				{
+					std::ifstream fin(job.filename, std::ios::binary | std::ios::ate);
+					if (!fin.is_open())
+						throw Exception(std::string("Unable to open ") + job.filename);
+					const size_t size = static_cast<size_t>(fin.tellg());
+					fin.seekg(0);
+
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						changed.wait(lock, [this, size]() {
+							return toDecode.size() + decoding == 0
+								|| (toDecode.size() < options.prefetchCount
+									&& (options.maxPrefetchedBytes == 0 || prefetchedBytes + size <= options.maxPrefetchedBytes));
+						});
+						prefetchedBytes += size;
+					}
+
+					job.content = std::make_shared<UninitializedBuffer<unsigned char> >(size);
+					fin.read(reinterpret_cast<char*>(job.content->data()), static_cast<std::streamsize>(size));
+					if (fin.fail())
+					{
+						{
+							std::lock_guard<std::mutex> lock(mutex);
+							prefetchedBytes -= size;
+						}
+						changed.notify_all();
+						throw Exception(std::string("Unable to read ") + job.filename);
+					}
+				}
+				catch (...)
+				{
+					job.promise.set_exception(std::current_exception());
+					continue;
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					toDecode.push_back(std::move(job));
+				}
+				changed.notify_all();
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				readerDone = true;
+			}
+			changed.notify_all();
+		}
+
+		/// Decode the files read in memory
+		void decodeFiles()
+		{
+			while (true)
+			{
+				Job job;
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					changed.wait(lock, [this]() { return !toDecode.empty() || readerDone; });
+					if (toDecode.empty())
+						break;
+					job = std::move(toDecode.front());
+					toDecode.pop_front();
+					++decoding;
+				}
+
+				const size_t size = job.content->size();
+				try
+				{
+					// With LoadOptions::memoryMapped, properties refer to the content, which they keep alive
+					MemoryRange memory;
+					memory.owner = job.content;
+					memory.begin = job.content->data();
+					memory.size = size;
+					PLYData data;
+					loadFromMemory(memory, data, options.load);
+					job.promise.set_value(std::move(data));
+				}
+				catch (...)
+				{
+					job.promise.set_exception(std::current_exception());
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					--decoding;
+					prefetchedBytes -= size;
+				}
+				changed.notify_all();
+			}
+		}
+
+		const AsyncLoadOptions options;
+		std::mutex mutex;
+		std::condition_variable changed;
+		/// Files requested but not read yet
+		std::deque<Job> toRead;
+		/// Files read in memory but not decoded yet
+		std::deque<Job> toDecode;
+		/// Number of files being decoded
+		size_t decoding = 0;
+		/// Total size of the files read in memory and not decoded yet
+		size_t prefetchedBytes = 0;
+		bool stopping = false;
+		bool readerDone = false;
+		std::thread reader;
+		std::vector<std::thread> decoders;
+	};
+
+	AsyncLoader::AsyncLoader(const AsyncLoadOptions& options)
+		: state(new AsyncLoaderState(options))
+	{}
+
+	AsyncLoader::~AsyncLoader()
+	{}
+
+	std::future<PLYData> AsyncLoader::load(const std::string& filename)
+	{
+		return state->load(filename);
+	}
+
+	PlyReader::PlyReader(const std::string& filename, const LoadOptions& options)
+		: fin(filename, std::ios::binary),
+		ascii(false),
+		swapBytes(false),
+		workers(new WorkerPool(getThreadsCount(options))),
+		elementsRead(0)
+	{
+		if (!fin.is_open())
+			throw Exception(std::string("Unable to open ") + filename);
+
+		checkUncompressed(fin.peek(), "PlyReader");
+		std::string format;
+		readHeader(fin, layout, format);
+		getSelectedData(layout, options, header_);
+		selectProperties(layout, options, skipped);
+
+		ascii = (format == "ascii");
+		if (ascii)
+			asciiTokenizer.reset(new ASCIITokenizer(fin));
+		else
+		{
+			swapBytes = needsByteSwap(format);
+			binaryReader.reset(new BinaryReader(fin));
+		}
+		currentElement = layout.begin();
+	}
+
+	PlyReader::~PlyReader()
+	{}
+
+	bool PlyReader::readBatch(const size_t maxCount, std::string& name, ElementArray& batch)
+	{
+		if (maxCount == 0)
+			throw Exception("Empty batches are not allowed");
+
+		while (true)
+		{
+			// Skip elements that have been fully read
+			while (currentIndex() < skipped.size() && elementsRead == currentElement->data->size())
+			{
+				++currentElement;
+				elementsRead = 0;
+			}
+
+			if (currentIndex() == skipped.size())
+			{
+				// Ensure we reached the end of file, unless the last elements are not read
+				if (currentElement == layout.end() && binaryReader && !binaryReader->atEnd())
+					throw Exception("End of file not reached at the end of parsing.");
+				return false;
+			}
+
+			// Step over the elements that are not selected at once
+			if (!header_.has_key(currentElement->key))
+			{
+				readRecords(*currentElement->data);
+				elementsRead = currentElement->data->size();
+				continue;
+			}
+			break;
+		}
+
+		const ElementArray& element = header_.get(currentElement->key);
+		name = currentElement->key;
+
+		// Reuse the properties of the previous batch if they match the element
+		bool sameProperties = true;
+		auto itBatch = batch.properties.begin();
+		for (auto itElement = element.properties.begin(); itElement != element.properties.end(); ++itElement, ++itBatch)
+		{
+			if (itBatch == batch.properties.end()
+				|| itBatch->key != itElement->key
+				|| itBatch->data->type != itElement->data->type
+				|| itBatch->data->isList != itElement->data->isList
+				|| itBatch->data->listCountType != itElement->data->listCountType
+				|| itBatch->data->isView())
+			{
+				sameProperties = false;
+				break;
+			}
+		}
+		if (!sameProperties || itBatch != batch.properties.end())
+		{
+			batch.properties.clear();
+			for (const auto& propertyTuple : element.properties)
 			{
-				auto& prop = propertyTuple.data;
-				readingPlace[prop.get()] = prop->data.data();
+				const auto& prop = propertyTuple.data;
+				PropertyArrayPtr batchProperty(new PropertyArray(prop->type, 0, prop->isList));
+				batchProperty->listCountType = prop->listCountType;
+				batch.properties.push_back(propertyTuple.key, batchProperty);
+			}
+		}
+
+		batch.size_ = std::min(maxCount, element.size() - elementsRead);
+		elementsRead += batch.size_;
+
+		// Records of the batch, in which properties that are not loaded are those of the layout
+		ElementArray records(batch.size_);
+		const SkippedProperties& elementSkipped = skipped[currentIndex()];
+		itBatch = batch.properties.begin();
+		size_t j = 0;
+		for (const auto& propertyTuple : currentElement->data->properties)
+		{
+			if (elementSkipped[j++])
+				records.properties.push_back(propertyTuple.key, propertyTuple.data);
+			else
+				records.properties.push_back(propertyTuple.key, (itBatch++)->data);
+		}
+		readRecords(records);
+		return true;
+	}
+
+	size_t PlyReader::currentIndex() const
+	{
+		return static_cast<size_t>(currentElement - layout.begin());
+	}
+
+	void PlyReader::readRecords(ElementArray& records)
+	{
+		const SkippedProperties& elementSkipped = skipped[currentIndex()];
+		if (ascii)
+		{
+			readASCIIElement(*asciiTokenizer, records, elementSkipped);
+		}
+		else
+		{
+			bool success;
+			if (hasListProperty(records))
+				success = readListBinaryElement(*binaryReader, records, elementSkipped, swapBytes);
+			else
+				success = readFixedStrideBinaryElement(*binaryReader, records, elementSkipped, buffer, *workers, swapBytes);
+
+			if (!success)
+				throw Exception("Issue while parsing binary data");
+		}
+	}
+
+
+	/// Step of an encode plan, resolved once per element from one of its properties
+	struct EncodeOp
+	{
+		const PropertyArray* prop;
+		bool isList;
+		/// Value of the i-th record, stored at 'values' + i * 'stride', or items of the lists
+		const unsigned char* values;
+		size_t stride;
+		size_t stepSize;
+		ASCIIFormatter formatter;
+		/// Encoder of the counts of binary lists, stored on 'countSize' bytes
+		ListCountEncoder countEncoder;
+		size_t countSize;
+	};
+
+	/// Operations writing the properties of a record, in order
+	typedef std::vector<EncodeOp> EncodePlan;
+
+	/// Compile the encode plan of an element.
+	/// List counts are encoded in their binary representation if 'binary' is set.
+	void compileEncodePlan(const ElementArray& elementArray, const bool binary, EncodePlan& plan)
+	{
+		plan.clear();
+		for (auto& propertyTuple : elementArray.properties)
+		{
+			const PropertyArray* prop = propertyTuple.data.get();
+			EncodeOp op;
+			op.prop = prop;
+			op.isList = prop->isList;
+			op.values = prop->bytes();
+			op.stride = prop->stride();
+			op.stepSize = prop->stepSize;
+			op.formatter = getASCIIFormatter(prop->type);
+			op.countEncoder = (binary && prop->isList) ? getListCountEncoder(prop->listCountType) : nullptr;
+			op.countSize = (binary && prop->isList) ? dataTypeToStepSize(prop->listCountType) : 0;
+			plan.push_back(op);
+		}
+	}
+
+	/// Write the records of an element into an ASCII body
+	void writeASCIIElement(ASCIIWriter& writer, const ElementArray& elementArray)
+	{
+		const ASCIIFormatter countFormatter = &formatASCIIInteger<size_t>;
+
+		EncodePlan plan;
+		compileEncodePlan(elementArray, false, plan);
+
+		// Iterate over elements
+		const size_t elementsCount = elementArray.size();
+		for (size_t i = 0; i < elementsCount; ++i)
+		{
+			// Walk the plan for each element
+			for (const EncodeOp& op : plan)
+			{
+				if (!op.isList)
+				{
+					// Safety check
+					assert(i < op.prop->size());
+					writer.write(op.formatter, op.values + i * op.stride);
+				}
+				else
+				{
+					const size_t count = op.prop->listSize(i);
+					const unsigned char* ptData = op.values + op.prop->listOffset(i) * op.stepSize;
+					// Safety check
+					assert(ptData + count * op.stepSize <= op.values + op.prop->size() * op.stepSize);
+					writer.write(countFormatter, reinterpret_cast<const unsigned char*>(&count));
+					for (size_t k = 0; k < count; ++k)
+						writer.write(op.formatter, ptData + k * op.stepSize);
+				}
 			}
+			writer.put('\n');
 		}
+	}
+
+	/// Write the body of an ASCII PLY file
+	void writeASCIIDataContent(std::ostream& fout, const PLYData& data)
+	{
+		ASCIIWriter writer(fout);
 
 		//// Iterate over elements array
 		for (auto& elementArrayTuple : data)
+			writeASCIIElement(writer, *elementArrayTuple.data);
+	}
+
+	/// Size of the blocks of records assembled before being written
+	const size_t binaryWriteBlockSize = 1 << 20;
+
+	/// Copy 'count' values, 'srcStride' bytes apart, into consecutive records of 'recordSize' bytes
+	template<size_t StepSize>
+	void interleave(const unsigned char* src, const size_t srcStride, const size_t count, const size_t recordSize, unsigned char* dst)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			std::memcpy(dst, src, StepSize);
+			src += srcStride;
+			dst += recordSize;
+		}
+	}
+
+	void interleave(const unsigned char* src, const size_t srcStride, const size_t count, const size_t stepSize, const size_t recordSize, unsigned char* dst)
+	{
+		switch (stepSize)
+		{
+		case 1:
+			interleave<1>(src, srcStride, count, recordSize, dst);
+			break;
+		case 2:
+			interleave<2>(src, srcStride, count, recordSize, dst);
+			break;
+		case 4:
+			interleave<4>(src, srcStride, count, recordSize, dst);
+			break;
+		case 8:
+			interleave<8>(src, srcStride, count, recordSize, dst);
+			break;
+		default:
+			throw Exception("Should not happen.");
+		}
+	}
+
+	/// Buffer of a binary body, written to the stream by large blocks
+	class BinaryWriter
+	{
+	public:
+		BinaryWriter(std::ostream& fout)
+			: fout(fout),
+			buffer(binaryWriteBlockSize)
+		{}
+
+		/// Append 'count' consecutive values, reversing their bytes if 'swapBytes' is set
+		void write(const unsigned char* ptData, size_t count, const size_t stepSize, bool swapBytes)
 		{
-			auto& elementArray = elementArrayTuple.data;
-			const size_t elementsCount = elementArray->size();
-			// Iterate over elements
-			for (size_t i = 0; i < elementsCount; ++i)
+			swapBytes = swapBytes && stepSize > 1;
+			if (position + count * stepSize <= buffer.size())
+			{
+				std::memcpy(&buffer[position], ptData, count * stepSize);
+				if (swapBytes)
+					byteSwapValues(&buffer[position], count, stepSize);
+				position += count * stepSize;
+				return;
+			}
+			while (count > 0)
 			{
-				// Iterate over properties of the element
-				for (auto& propertyTuple : elementArray->properties)
+				const size_t available = (buffer.size() - position) / stepSize;
+				if (available == 0)
 				{
-					auto& prop = propertyTuple.data;
-					// Write data
-					auto& ptData = readingPlace[prop.get()];
-					if (!prop->isList)
+					flush();
+					continue;
+				}
+				// Large writes bypass the buffer when they do not need to be modified
+				if (!swapBytes && position == 0 && count * stepSize >= buffer.size())
+				{
+					fout.write(reinterpret_cast<const char*>(ptData), count * stepSize);
+					return;
+				}
+
+				const size_t chunkCount = std::min(available, count);
+				std::memcpy(&buffer[position], ptData, chunkCount * stepSize);
+				if (swapBytes)
+					byteSwapValues(&buffer[position], chunkCount, stepSize);
+				position += chunkCount * stepSize;
+				ptData += chunkCount * stepSize;
+				count -= chunkCount;
+			}
+		}
+
+		/// Write the content of the buffer to the stream
+		void flush()
+		{
+			fout.write(reinterpret_cast<const char*>(buffer.data()), position);
+			position = 0;
+		}
+
+	private:
+		std::ostream& fout;
+		UninitializedBuffer<unsigned char> buffer;
+		size_t position = 0;
+	};
+
+	/// Write the records of an element without list properties, assembled by blocks from its properties
+	void writeFixedStrideBinaryElement(std::ostream& fout, const ElementArray& elementArray, const bool swapBytes)
+	{
+		const size_t recordSize = getRecordSize(elementArray);
+		const size_t elementsCount = elementArray.size();
+		if (recordSize == 0 || elementsCount == 0)
+			return;
+
+		// Contiguous values of properties of the same type are interleaved with packValues
+		std::vector<const unsigned char*> channels;
+		bool uniform = true;
+		const size_t firstStepSize = elementArray.properties.begin()->data->stepSize;
+		for (const auto& propertyTuple : elementArray.properties)
+		{
+			const PropertyArray& prop = *propertyTuple.data;
+			assert(prop.size() == elementsCount);
+			uniform = uniform && prop.stride() == prop.stepSize && prop.stepSize == firstStepSize;
+			channels.push_back(prop.bytes());
+		}
+
+		// A single contiguous property is already laid out as in the file
+		if (uniform && channels.size() == 1)
+		{
+			BinaryWriter writer(fout);
+			writer.write(channels[0], elementsCount, recordSize, swapBytes);
+			writer.flush();
+			return;
+		}
+
+		const size_t recordsPerBlock = std::max<size_t>(1, binaryWriteBlockSize / recordSize);
+		UninitializedBuffer<unsigned char> block(std::min(recordsPerBlock, elementsCount) * recordSize);
+		std::vector<const unsigned char*> blockChannels(channels.size());
+		// Column of a property for a block, contiguous to be swapped at once
+		UninitializedBuffer<unsigned char> column((swapBytes && !uniform) ? std::min(recordsPerBlock, elementsCount) * sizeof(uint64_t) : 0);
+		for (size_t first = 0; first < elementsCount; first += recordsPerBlock)
+		{
+			const size_t count = std::min(recordsPerBlock, elementsCount - first);
+			if (uniform)
+			{
+				const size_t stepSize = recordSize / channels.size();
+				for (size_t j = 0; j < channels.size(); ++j)
+					blockChannels[j] = channels[j] + first * stepSize;
+				packValues(blockChannels.data(), channels.size(), stepSize, count, block.data());
+				if (swapBytes)
+					byteSwapValues(block.data(), count * channels.size(), stepSize);
+			}
+			else
+			{
+				size_t offset = 0;
+				for (const auto& propertyTuple : elementArray.properties)
+				{
+					const PropertyArray& prop = *propertyTuple.data;
+					const unsigned char* values = prop.bytes() + first * prop.stride();
+					size_t stride = prop.stride();
+					if (swapBytes && prop.stepSize > 1)
 					{
-						// Safety check
-						assert(ptData >= prop->data.data());
-						assert(ptData + prop->stepSize <= prop->data.data() + prop->data.size());
-						if (format == FileFormat::BINARY)
-							fout.write(reinterpret_cast<const char*>(ptData), prop->stepSize);
-						else
-						{
-							writeASCIIValue(fout, ptData, prop->type);
-							fout << " ";
-						}
-						ptData += prop->stepSize;
+						interleave(values, stride, count, prop.stepSize, prop.stepSize, column.data());
+						byteSwapValues(column.data(), count, prop.stepSize);
+						values = column.data();
+						stride = prop.stepSize;
 					}
-					else
-					{
-						if (format == FileFormat::BINARY)
-						{
-							const unsigned char count = 3;
-							// Write the number of elements
-							fout.write(reinterpret_cast<const char*>(&count), sizeof(unsigned char));
-							// Write data
-							const size_t chunckSize = 3 * prop->stepSize;
-							// Safety check
-							assert(ptData >= prop->data.data());
-							assert(ptData + chunckSize <= prop->data.data() + prop->data.size());
-							fout.write(reinterpret_cast<const char*>(ptData), chunckSize);
-							ptData += chunckSize;
-						}
-						else
-						{
-							fout << "3 ";
-							writeASCIIValue(fout, ptData, prop->type);
-							fout << " ";
-							ptData += prop->stepSize;
-							writeASCIIValue(fout, ptData, prop->type);
-							fout << " ";
-							ptData += prop->stepSize;
-							writeASCIIValue(fout, ptData, prop->type);
-							fout << " ";
-							ptData += prop->stepSize;
-						}
+					interleave(values, stride, count, prop.stepSize, recordSize, block.data() + offset);
+					offset += prop.stepSize;
+				}
+			}
+			fout.write(reinterpret_cast<const char*>(block.data()), count * recordSize);
+		}
+	}
 
-					}
+	/// Write the records of an element into a binary body, reversing the bytes of each value if 'swapBytes' is set
+	void writeBinaryElement(std::ostream& fout, const ElementArray& elementArray, const bool swapBytes)
+	{
+		// Interleaved records are already laid out as in the file
+		if (!swapBytes && elementArray.isInterleaved())
+		{
+			fout.write(reinterpret_cast<const char*>(elementArray.recordsBytes()), elementArray.size() * elementArray.recordSize());
+			return;
+		}
+
+		if (!hasListProperty(elementArray))
+			return writeFixedStrideBinaryElement(fout, elementArray, swapBytes);
 
+		EncodePlan plan;
+		compileEncodePlan(elementArray, true, plan);
+		BinaryWriter writer(fout);
 
+		// Iterate over elements
+		const size_t elementsCount = elementArray.size();
+		for (size_t i = 0; i < elementsCount; ++i)
+		{
+			// Walk the plan for each element
+			for (const EncodeOp& op : plan)
+			{
+				if (!op.isList)
+				{
+					// Safety check
+					assert(i < op.prop->size());
+					writer.write(op.values + i * op.stride, 1, op.stepSize, swapBytes);
 				}
-				if (format == FileFormat::ASCII)
+				else
 				{
-					fout << "\n";
+					// Write the number of elements
+					const size_t count = op.prop->listSize(i);
+					unsigned char countData[sizeof(uint32_t)];
+					if (!op.countEncoder(count, countData))
+						throw Exception("List too long for its counting type");
+					writer.write(countData, 1, op.countSize, swapBytes);
+					// Write data
+					const unsigned char* ptData = op.values + op.prop->listOffset(i) * op.stepSize;
+					// Safety check
+					assert(ptData + count * op.stepSize <= op.values + op.prop->size() * op.stepSize);
+					writer.write(ptData, count, op.stepSize, swapBytes);
 				}
 			}
 		}
+		writer.flush();
 	}
 
-	void save(const std::string& filename, const PLYData& data, const FileFormat format)
+	/// Write the body of a binary PLY file, reversing the bytes of each value if 'swapBytes' is set
+	void writeBinaryDataContent(std::ostream& fout, const PLYData& data, const bool swapBytes)
 	{
-		std::ofstream fout(filename, std::ios::binary);
+		//// Iterate over elements array
+		for (auto& elementArrayTuple : data)
+			writeBinaryElement(fout, *elementArrayTuple.data, swapBytes);
+	}
 
-		// Write header
+	/// Whether values are written in big endian for a given format
+	bool isBigEndianFormat(const FileFormat format)
+	{
+		return (format == FileFormat::BINARY_BIG_ENDIAN)
+			|| (format == FileFormat::BINARY && isBigEndianArchitecture());
+	}
+
+	/// Write the first lines of a header
+	void writeFormatHeader(std::ostream& fout, const FileFormat format)
+	{
 		fout << "ply\n";
 		switch (format)
 		{
@@ -566,7 +4232,9 @@ namespace plycpp
 			fout << "format ascii 1.0\n";
 			break;
 		case FileFormat::BINARY:
-			if (isBigEndianArchitecture())
+		case FileFormat::BINARY_LITTLE_ENDIAN:
+		case FileFormat::BINARY_BIG_ENDIAN:
+			if (isBigEndianFormat(format))
 				fout << "format binary_big_endian 1.0\n";
 			else
 				fout << "format binary_little_endian 1.0\n";
@@ -575,60 +4243,168 @@ namespace plycpp
 			throw Exception("Unknown file format. Should not happen.");
 			break;
 		}
+	}
 
-		// Iterate over elements array
-		for (const auto& elementArrayTuple : data)
+	/// Ensure each property of an element holds one value or one list per record
+	void checkElementProperties(const std::string& elementArrayName, const ElementArray& elementArray)
+	{
+		const size_t elementsCount = elementArray.size();
+		for (const auto& propertyTuple : elementArray.properties)
 		{
-			const auto& elementArrayName = elementArrayTuple.key;
-			auto& elementArray = elementArrayTuple.data;
-			const size_t elementsCount = elementArray->size();
+			auto& propName = propertyTuple.key;
+			auto& prop = propertyTuple.data;
+
+			if (!prop)
+				throw Exception("Null property " + elementArrayName + " -- " + propName);
 
-			fout << "element " << elementArrayName << " " << elementsCount << std::endl;
-			// Iterate over properties
-			for (const auto& propertyTuple : elementArray->properties)
+			if (!prop->isList)
 			{
-				auto& propName = propertyTuple.key;
-				auto& prop = propertyTuple.data;
+				if (prop->size() != elementsCount)
+				{
+					throw Exception("Inconsistent size for " + elementArrayName + " -- " + propName);
+				}
+			}
+			else
+			{
+				const bool consistentSize = prop->offsets.empty()
+					? prop->size() == 3 * elementsCount
+					: prop->offsets.size() == elementsCount + 1 && prop->offsets.front() == 0 && prop->offsets.back() == prop->size();
+				if (!consistentSize)
+				{
+					throw Exception("Inconsistent size for list " + elementArrayName + " -- " + propName);
+				}
+			}
+		}
+	}
 
-				if (!prop)
-					throw Exception("Null property " + elementArrayName + " -- " + propName);
+	/// Width of the number of records of an element written in a header before being known
+	const int deferredCountWidth = std::numeric_limits<size_t>::digits10 + 1;
 
-				// String name of the property type
-				const auto& itTypeName = dataTypeToStr.find(prop->type);
-				if (itTypeName == dataTypeToStr.end())
-					throw Exception("Should not happen");
+	/// Write the declaration of an element and of its properties.
+	/// If 'deferredCount' is set, the number of records is written on a fixed width to be patched later,
+	/// and its position is returned.
+	std::streampos writeElementHeader(std::ostream& fout, const std::string& elementArrayName, const ElementArray& elementArray, const bool deferredCount)
+	{
+		fout << "element " << elementArrayName << " ";
+		const std::streampos countPosition = fout.tellp();
+		if (deferredCount)
+			fout << std::string(deferredCountWidth, '0') << "\n";
+		else
+			fout << elementArray.size() << "\n";
 
-				if (!prop->isList)
-				{
-					if (prop->data.size() != elementsCount * prop->stepSize)
-					{
-						throw Exception("Inconsistent size for " + elementArrayName + " -- " + propName);
-					}
+		// Iterate over properties
+		for (const auto& propertyTuple : elementArray.properties)
+		{
+			auto& propName = propertyTuple.key;
+			auto& prop = propertyTuple.data;
 
-					fout << "property " << itTypeName->second << " " << propName << std::endl;
-				}
-				else
-				{
-					if (prop->data.size() != 3 * elementsCount * prop->stepSize)
-					{
-						throw Exception("Inconsistent size for list " + elementArrayName + " -- " + propName);
-					}
+			if (!prop)
+				throw Exception("Null property " + elementArrayName + " -- " + propName);
 
-					fout << "property list uchar " << itTypeName->second << " " << propName << std::endl;
-				}
+			// String name of the property type
+			const auto& itTypeName = dataTypeToStr.find(prop->type);
+			if (itTypeName == dataTypeToStr.end())
+				throw Exception("Should not happen");
+
+			if (!prop->isList)
+			{
+				fout << "property " << itTypeName->second << " " << propName << "\n";
+			}
+			else
+			{
+				// Ensure the counting type is an integral one
+				getListCountEncoder(prop->listCountType);
 
+				fout << "property list " << dataTypeToString(prop->listCountType) << " " << itTypeName->second << " " << propName << "\n";
 			}
 		}
+		return countPosition;
+	}
+
+	void save(const std::string& filename, const PLYData& data, const FileFormat format)
+	{
+		save(filename, data, format, CompressionOptions(compressionFromExtension(filename)));
+	}
+
+	void save(const std::string& filename, const PLYData& data, const FileFormat format, const CompressionOptions& compression)
+	{
+		SaveOptions options;
+		options.format = format;
+		options.compression = compression;
+		save(filename, data, options);
+	}
+
+	void save(const std::string& filename, const PLYData& data, const SaveOptions& options)
+	{
+		// Checked before the file is created or truncated
+		if (!isCompressionSupported(options.compression.compression))
+			throw unsupportedCompression(options.compression.compression);
+
+#ifdef __linux__
+		if (options.directIO)
+		{
+			DirectOutputStreamBuffer buffer(filename);
+			std::ostream fout(&buffer);
+			save(fout, data, options.format, options.compression);
+			if (!buffer.finish())
+				throw Exception(std::string("Problem while writing ") + filename);
+			return;
+		}
+#endif
+		std::ofstream fout(filename, std::ios::binary);
+		if (!fout.is_open())
+			throw Exception(std::string("Unable to open ") + filename);
+
+		save(fout, data, options.format, options.compression);
+	}
+
+	void save(std::vector<unsigned char>& buffer, const PLYData& data, const FileFormat format)
+	{
+		save(buffer, data, format, CompressionOptions());
+	}
+
+	void save(std::vector<unsigned char>& buffer, const PLYData& data, const FileFormat format, const CompressionOptions& compression)
+	{
+		VectorStreamBuffer streamBuffer(buffer);
+		std::ostream fout(&streamBuffer);
+		save(fout, data, format, compression);
+	}
+
+	void save(std::ostream& fout, const PLYData& data, const FileFormat format, const CompressionOptions& compression)
+	{
+		if (compression.compression == Compression::UNCOMPRESSED)
+			return save(fout, data, format);
+
+		std::unique_ptr<CompressingStreamBuffer> buffer = makeCompressingStreamBuffer(compression, *fout.rdbuf());
+		std::ostream compressed(buffer.get());
+		save(compressed, data, format);
+		if (!buffer->finish() || fout.fail())
+			throw Exception("Problem while writing compressed data");
+	}
+
+	void save(std::ostream& fout, const PLYData& data, const FileFormat format)
+	{
+		// Write header
+		writeFormatHeader(fout, format);
+
+		// Iterate over elements array
+		for (const auto& elementArrayTuple : data)
+		{
+			checkElementProperties(elementArrayTuple.key, *elementArrayTuple.data);
+			writeElementHeader(fout, elementArrayTuple.key, *elementArrayTuple.data, false);
+		}
 		fout << "end_header" << std::endl;
 
 		// Write data
 		switch (format)
 		{
 		case FileFormat::BINARY:
-			writeDataContent<FileFormat::BINARY>(fout, data);
+		case FileFormat::BINARY_LITTLE_ENDIAN:
+		case FileFormat::BINARY_BIG_ENDIAN:
+			writeBinaryDataContent(fout, data, isBigEndianFormat(format) != isBigEndianArchitecture());
 			break;
 		case FileFormat::ASCII:
-			writeDataContent<FileFormat::ASCII>(fout, data);
+			writeASCIIDataContent(fout, data);
 			break;
 		default:
 			throw Exception("Unknown file format. Should not happen.");
@@ -641,4 +4417,140 @@ namespace plycpp
 			throw Exception("Problem while writing binary data");
 		}
 	}
-}
\ No newline at end of file
+
+	PlyWriter::PlyWriter(const std::string& filename, const PLYData& schema, const FileFormat format, const bool deferredSizes)
+		: fout(filename, std::ios::binary),
+		swapBytes(isBigEndianFormat(format) != isBigEndianArchitecture()),
+		deferredSizes(deferredSizes),
+		closed(false)
+	{
+		if (!fout.is_open())
+			throw Exception(std::string("Unable to open ") + filename);
+
+		// Keep the schema without its data
+		for (const auto& elementArrayTuple : schema)
+		{
+			std::shared_ptr<ElementArray> element(new ElementArray(elementArrayTuple.data->size()));
+			for (const auto& propertyTuple : elementArrayTuple.data->properties)
+			{
+				const auto& prop = propertyTuple.data;
+				if (!prop)
+					throw Exception("Null property " + elementArrayTuple.key + " -- " + propertyTuple.key);
+				PropertyArrayPtr schemaProperty(new PropertyArray(prop->type, 0, prop->isList));
+				schemaProperty->listCountType = prop->listCountType;
+				element->properties.push_back(propertyTuple.key, schemaProperty);
+			}
+			schema_.push_back(elementArrayTuple.key, element);
+		}
+
+		// Write header
+		writeFormatHeader(fout, format);
+		for (const auto& elementArrayTuple : schema_)
+			countPositions.push_back(writeElementHeader(fout, elementArrayTuple.key, *elementArrayTuple.data, deferredSizes));
+		fout << "end_header\n";
+
+		if (format == FileFormat::ASCII)
+			asciiWriter.reset(new ASCIIWriter(fout));
+		currentElement = schema_.begin();
+		elementsWritten.assign(countPositions.size(), 0);
+	}
+
+	PlyWriter::~PlyWriter()
+	{
+		if (!closed)
+		{
+			try
+			{
+				close();
+			}
+			catch (...)
+			{}
+		}
+	}
+
+	void PlyWriter::writeBatch(const std::string& name, const ElementArray& batch)
+	{
+		if (closed)
+			throw Exception("Writing into a closed PlyWriter");
+
+		// Elements are written in the order of the schema
+		while (currentElement != schema_.end() && currentElement->key != name)
+		{
+			checkElementWritten();
+			++currentElement;
+		}
+		if (currentElement == schema_.end())
+			throw Exception("Element " + name + " is not expected at this point of the file");
+
+		// Ensure the batch matches the schema
+		const ElementArray& element = *currentElement->data;
+		auto itBatch = batch.properties.begin();
+		for (auto itElement = element.properties.begin(); itElement != element.properties.end(); ++itElement, ++itBatch)
+		{
+			if (itBatch == batch.properties.end()
+				|| itBatch->key != itElement->key
+				|| !itBatch->data
+				|| itBatch->data->type != itElement->data->type
+				|| itBatch->data->isList != itElement->data->isList
+				|| (itBatch->data->isList && itBatch->data->listCountType != itElement->data->listCountType))
+			{
+				throw Exception("Properties of the batch do not match the element " + name);
+			}
+		}
+		if (itBatch != batch.properties.end())
+			throw Exception("Properties of the batch do not match the element " + name);
+		checkElementProperties(name, batch);
+
+		size_t& written = elementsWritten[currentElement - schema_.begin()];
+		if (!deferredSizes && written + batch.size() > element.size())
+			throw Exception("Too many records written for " + name);
+
+		// Write data
+		if (asciiWriter)
+			writeASCIIElement(*asciiWriter, batch);
+		else
+			writeBinaryElement(fout, batch, swapBytes);
+		written += batch.size();
+
+		if (fout.fail())
+		{
+			throw Exception("Problem while writing binary data");
+		}
+	}
+
+	void PlyWriter::close()
+	{
+		if (closed)
+			return;
+		closed = true;
+
+		for (; currentElement != schema_.end(); ++currentElement)
+			checkElementWritten();
+
+		// Flush remaining ASCII data
+		asciiWriter.reset();
+
+		// Patch the number of records of each element
+		if (deferredSizes)
+		{
+			for (size_t i = 0; i < countPositions.size(); ++i)
+			{
+				fout.seekp(countPositions[i]);
+				fout << std::setw(deferredCountWidth) << std::setfill('0') << elementsWritten[i];
+			}
+		}
+		fout.close();
+
+		if (fout.fail())
+		{
+			throw Exception("Problem while writing binary data");
+		}
+	}
+
+	void PlyWriter::checkElementWritten()
+	{
+		const size_t written = elementsWritten[currentElement - schema_.begin()];
+		if (!deferredSizes && written != currentElement->data->size())
+			throw Exception("Inconsistent number of records written for " + currentElement->key);
+	}
+}